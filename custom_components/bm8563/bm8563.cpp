@@ -1,21 +1,57 @@
 #include "esphome/core/log.h"
 #include "esphome/components/i2c/i2c_bus.h"
 #include "bm8563.h"
+#include "esphome/core/helpers.h"
+#include <algorithm>
+#include <ctime>
 
 namespace esphome {
 namespace bm8563 {
 
 static const char *TAG = "bm8563.sensor";
 
+// furthest the day of month alarm can reach without matching a day too early
+static const uint32_t MAX_ALARM_AHEAD = 27 * 86400;
+
 void BM8563::setup(){
+  // TF and AF tell why we are up, read them before the control registers are cleared. A flag only
+  // counts with its interrupt enabled, the timer and the alarm set their flag either way
+  uint8_t status;
+  if (this->read_register(0x01, &status, 1) == i2c::ERROR_OK) {
+    this->alarm_wake_ = ((status & 0x04) && (status & 0x01)) || ((status & 0x08) && (status & 0x02));
+  }
   this->write_byte_16(0,0);
+  // stop the timer and disable every alarm field, so a stale one can't pull the interrupt line later
+  WriteReg(0x0E, 0x03);
+  uint8_t alarm_off[4] = {0x80, 0x80, 0x80, 0x80};
+  this->write_register(0x09, alarm_off, 4);
   this->setupComplete = true;
+  this->read_time();
+
+  // the target survives main power cuts, RTC memory of the ESP32 does not
+  this->wake_pref_ = global_preferences->make_preference<uint32_t>(fnv1_hash("bm8563_wake_target"), true);
+  uint32_t target;
+  if (this->wake_pref_.load(&target) && target != 0) {
+    this->wake_target_ = target;
+    auto now = this->utcnow();
+    if (now.is_valid() && now.timestamp + 60 < target) {
+      ESP_LOGD(TAG, "Chained wake, %u s left", target - now.timestamp);
+      this->chained_wake_ = true;
+      this->schedule_wake_at(target);
+    } else {
+      this->store_wake_target_(0);
+    }
+  }
 }
 
+/// Only go to the chip once the resync interval is up, the system clock keeps the time in between
 void BM8563::update(){
   if(!this->setupComplete){
      return;
   }
+  if (this->rtc_epoch_ != 0 && millis() - this->rtc_read_ms_ < this->resync_interval_) {
+    return;
+  }
   this->read_time();
 }
 
@@ -23,22 +59,137 @@ void BM8563::dump_config(){
   ESP_LOGCONFIG(TAG, "BM8563:");
   ESP_LOGCONFIG(TAG, "  Address: 0x%02X", this->address_);
   ESP_LOGCONFIG(TAG, "  setupComplete: %s", this->setupComplete ? "true" : "false");
+  ESP_LOGCONFIG(TAG, "  Resync Interval: %u ms", this->resync_interval_);
+  ESP_LOGCONFIG(TAG, "  Alarm Wake: %s", YESNO(this->alarm_wake_));
   if (this->sleep_duration_.has_value()) {
     uint32_t duration = *this->sleep_duration_;
     ESP_LOGCONFIG(TAG, "  Sleep Duration: %u ms", duration);
   }
+  for (auto &wake_time : this->wake_times_) {
+    if (wake_time.hour < 0) {
+      ESP_LOGCONFIG(TAG, "  Wake Time: every hour at :%02u", wake_time.minute);
+    } else {
+      ESP_LOGCONFIG(TAG, "  Wake Time: %02i:%02u", wake_time.hour, wake_time.minute);
+    }
+  }
 }
 
 void BM8563::set_sleep_duration(uint32_t time_s) {
-  ESP_LOGE(TAG, "Sleep Duration Setting to: %u ms", time_s);
   this->sleep_duration_ = time_s;
 }
 
 void BM8563::apply_sleep_duration() {
-  if (this->sleep_duration_.has_value() && this->setupComplete) {
-    this->clearIRQ();
-    this->SetAlarmIRQ(*this->sleep_duration_);
+  if (!this->setupComplete) {
+    return;
+  }
+  auto now = this->utcnow();
+  if (!now.is_valid()) {
+    // no clock to plan the wake times with, the countdown timer still works
+    if (this->sleep_duration_.has_value()) {
+      this->schedule_wake(*this->sleep_duration_ / 1000);
+    }
+    return;
+  }
+
+  optional<uint32_t> target = this->next_wake_time_(now.timestamp);
+  if (this->sleep_duration_.has_value()) {
+    uint32_t after_duration = now.timestamp + *this->sleep_duration_ / 1000;
+    if (!target.has_value() || after_duration < *target) {
+      target = after_duration;
+    }
+  }
+  if (target.has_value()) {
+    this->schedule_wake_at(*target);
+  }
+}
+
+bool BM8563::schedule_wake(uint32_t seconds) {
+  auto now = this->utcnow();
+  if (now.is_valid()) {
+    return this->schedule_wake_at(now.timestamp + seconds);
+  }
+  // the timer counts minutes beyond 255 s and can't go past 255 of them
+  this->clearIRQ();
+  this->SetAlarmIRQ(int(std::min<uint32_t>(seconds, 255 * 60)));
+  return seconds <= 255 * 60;
+}
+
+bool BM8563::schedule_wake_at(uint32_t target) {
+  auto now = this->utcnow();
+  if (!now.is_valid()) {
+    ESP_LOGW(TAG, "Invalid system time, can't schedule a wake.");
+    return false;
+  }
+  uint32_t ahead = target > now.timestamp ? target - now.timestamp : 1;
+
+  this->clearIRQ();
+  if (ahead <= 255) {
+    this->SetAlarmIRQ(int(ahead));
+    this->store_wake_target_(0);
+    return true;
+  }
+
+  uint32_t link = ahead > MAX_ALARM_AHEAD ? now.timestamp + MAX_ALARM_AHEAD : target;
+  // the alarm matches at the start of a minute, don't wake before the target
+  link = (link + 59) / 60 * 60;
+  time::ESPTime at = time::ESPTime::from_epoch_utc(link);
+  BM8563_TimeTypeDef BM8563_TimeStruct = {
+    hours: int8_t(at.hour),
+    minutes: int8_t(at.minute),
+    seconds: 0,
+  };
+  BM8563_DateTypeDef BM8563_DateStruct = {
+    day: int8_t(at.day_of_month),
+    week: -1,
+    month: -1,
+    year: -1,
+  };
+  this->SetAlarmIRQ(BM8563_DateStruct, BM8563_TimeStruct);
+  this->store_wake_target_(link < target ? target : 0);
+  ESP_LOGD(TAG, "Wake at %04u-%02u-%02u %02u:%02u UTC%s", at.year, at.month, at.day_of_month, at.hour, at.minute,
+           link < target ? ", chained" : "");
+  return true;
+}
+
+/// Soonest wall clock wake after now, wake times are local time
+optional<uint32_t> BM8563::next_wake_time_(uint32_t now) {
+  optional<uint32_t> next;
+  for (auto &wake_time : this->wake_times_) {
+    time_t now_t = now;
+    struct tm tm;
+    localtime_r(&now_t, &tm);
+    tm.tm_sec = 0;
+    tm.tm_min = wake_time.minute;
+    if (wake_time.hour >= 0) {
+      tm.tm_hour = wake_time.hour;
+    }
+    tm.tm_isdst = -1;
+    time_t candidate = mktime(&tm);
+    if (candidate <= now_t) {
+      // mktime normalizes the overflow and takes care of DST changes in between
+      if (wake_time.hour >= 0) {
+        tm.tm_mday++;
+      } else {
+        tm.tm_hour++;
+      }
+      tm.tm_isdst = -1;
+      candidate = mktime(&tm);
+    }
+    if (!next.has_value() || uint32_t(candidate) < *next) {
+      next = uint32_t(candidate);
+    }
+  }
+  return next;
+}
+
+void BM8563::store_wake_target_(uint32_t target) {
+  // flash writes only when the chain starts or ends
+  if (target == this->wake_target_) {
+    return;
   }
+  this->wake_target_ = target;
+  this->wake_pref_.save(&target);
+  global_preferences->sync();
 }
 
 void BM8563::write_time() {
@@ -63,23 +214,18 @@ void BM8563::write_time() {
 
   this->setTime(&BM8563_TimeStruct);
   this->setDate(&BM8563_DateStruct);
+  // the chip now holds the system time, no need to read it back before the next resync
+  this->rtc_epoch_ = now.timestamp;
+  this->rtc_read_ms_ = millis();
 }
 
 void BM8563::read_time() {
-
   BM8563_TimeTypeDef BM8563_TimeStruct;
   BM8563_DateTypeDef BM8563_DateStruct;
-  getTime(&BM8563_TimeStruct);
-  getDate(&BM8563_DateStruct);
-  ESP_LOGE(TAG, "BM8563: %i-%i-%i %i, %i:%i:%i", 
-    BM8563_DateStruct.year,
-    BM8563_DateStruct.month,
-    BM8563_DateStruct.day,
-    BM8563_DateStruct.week,
-    BM8563_TimeStruct.hours, 
-    BM8563_TimeStruct.minutes, 
-    BM8563_TimeStruct.seconds
-  );
+  if (!this->getDateTime(&BM8563_DateStruct, &BM8563_TimeStruct)) {
+    ESP_LOGW(TAG, "Failed to read time");
+    return;
+  }
 
   time::ESPTime rtc_time{.second = uint8_t(BM8563_TimeStruct.seconds),
                          .minute = uint8_t(BM8563_TimeStruct.minutes),
@@ -91,6 +237,25 @@ void BM8563::read_time() {
                          .year = uint16_t(BM8563_DateStruct.year)
                          };
   rtc_time.recalc_timestamp_utc(false);
+
+  uint32_t now_ms = millis();
+  if (this->rtc_epoch_ != 0) {
+    // where the last read says the clock should be by now
+    uint32_t expected = this->rtc_epoch_ + (now_ms - this->rtc_read_ms_) / 1000;
+    int32_t drift = int32_t(rtc_time.timestamp - expected);
+    this->rtc_epoch_ = rtc_time.timestamp;
+    this->rtc_read_ms_ = now_ms;
+    if (drift >= -1 && drift <= 1) {
+      ESP_LOGV(TAG, "System time still in sync");
+      return;
+    }
+    ESP_LOGD(TAG, "System time drifted by %d s", drift);
+  }
+  this->rtc_epoch_ = rtc_time.timestamp;
+  this->rtc_read_ms_ = now_ms;
+
+  ESP_LOGD(TAG, "Read %04i-%02i-%02i %02i:%02i:%02i", BM8563_DateStruct.year, BM8563_DateStruct.month,
+           BM8563_DateStruct.day, BM8563_TimeStruct.hours, BM8563_TimeStruct.minutes, BM8563_TimeStruct.seconds);
   time::RealTimeClock::synchronize_epoch_(rtc_time.timestamp);
 }
 
@@ -116,14 +281,36 @@ uint8_t BM8563::byteToBcd2(uint8_t value) {
   return ((uint8_t)(bcdhigh << 4) | value);
 }
 
-void BM8563::getTime(BM8563_TimeTypeDef* BM8563_TimeStruct) {
-  uint8_t buf[3] = {0};
-
-  this->read_register(0x02, buf, 3);
+/** Read seconds through years in one burst from 0x02
+ *
+ * The chip latches all time registers while the address auto-increments, so the fields can't tear
+ * across a second boundary like separate reads of the time and the date could.
+ */
+bool BM8563::getDateTime(BM8563_DateTypeDef* BM8563_DateStruct, BM8563_TimeTypeDef* BM8563_TimeStruct) {
+  uint8_t buf[7] = {0};
+  if (this->read_register(0x02, buf, 7) != i2c::ERROR_OK) {
+    return false;
+  }
+  if (buf[0] & 0x80) {
+    // VL flag, the oscillator stopped at some point
+    ESP_LOGW(TAG, "Clock integrity is not guaranteed");
+  }
 
   BM8563_TimeStruct->seconds = bcd2ToByte(buf[0] & 0x7f);
   BM8563_TimeStruct->minutes = bcd2ToByte(buf[1] & 0x7f);
   BM8563_TimeStruct->hours   = bcd2ToByte(buf[2] & 0x3f);
+
+  BM8563_DateStruct->day   = bcd2ToByte(buf[3] & 0x3f);
+  BM8563_DateStruct->week  = bcd2ToByte(buf[4] & 0x07);
+  BM8563_DateStruct->month = bcd2ToByte(buf[5] & 0x1f);
+
+  uint8_t year_byte = bcd2ToByte(buf[6]);
+  if (buf[5] & 0x80) {
+    BM8563_DateStruct->year = 1900 + year_byte;
+  } else {
+    BM8563_DateStruct->year = 2000 + year_byte;
+  }
+  return true;
 }
 
 void BM8563::setTime(BM8563_TimeTypeDef* BM8563_TimeStruct) {
@@ -139,23 +326,6 @@ void BM8563::setTime(BM8563_TimeTypeDef* BM8563_TimeStruct) {
   this->write_register(0x02, buf, 3);
 }
 
-void BM8563::getDate(BM8563_DateTypeDef* BM8563_DateStruct) {
-  uint8_t buf[4] = {0};
-  this->read_register(0x05, buf, 5);
-
-  BM8563_DateStruct->day    = bcd2ToByte(buf[0] & 0x3f);
-  BM8563_DateStruct->week = bcd2ToByte(buf[1] & 0x07);
-  BM8563_DateStruct->month   = bcd2ToByte(buf[2] & 0x1f);
-
-  uint8_t year_byte = bcd2ToByte(buf[3] & 0xff);
-  ESP_LOGE(TAG, "Year byte is %i", year_byte);
-  if (buf[2] & 0x80) {
-    BM8563_DateStruct->year = 1900 + year_byte;
-  } else {
-    BM8563_DateStruct->year = 2000 + year_byte;
-  }
-}
-
 void BM8563::setDate(BM8563_DateTypeDef* BM8563_DateStruct) {
   if (BM8563_DateStruct == NULL) {
     return;
@@ -174,7 +344,6 @@ void BM8563::setDate(BM8563_DateTypeDef* BM8563_DateStruct) {
     buf[2] = byteToBcd2(BM8563_DateStruct->month) | 0x00;
   }
 
-  ESP_LOGE(TAG, "WRiting year is %i", buf[3]);
   this->write_register(0x05, buf, 4);
 }
 
@@ -189,7 +358,7 @@ uint8_t BM8563::ReadReg(uint8_t reg) {
 }
 
 int BM8563::SetAlarmIRQ(int afterSeconds) {
-  ESP_LOGE(TAG, "Sleep Duration: %u ms", afterSeconds);
+  ESP_LOGD(TAG, "Sleep Duration: %i s", afterSeconds);
   uint8_t reg_value = 0;
   reg_value = ReadReg(0x01);
 
@@ -216,10 +385,58 @@ int BM8563::SetAlarmIRQ(int afterSeconds) {
 
   reg_value |= (1 << 0);
   reg_value &= ~(1 << 7);
+  // the alarm shares the interrupt line
+  reg_value &= ~(1 << 1);
   WriteReg(0x01, reg_value);
   return afterSeconds * div;
 }
 
+int BM8563::SetAlarmIRQ(const BM8563_TimeTypeDef &BM8563_TimeStruct) {
+  BM8563_DateTypeDef BM8563_DateStruct = {
+    day: -1,
+    week: -1,
+    month: -1,
+    year: -1,
+  };
+  return this->SetAlarmIRQ(BM8563_DateStruct, BM8563_TimeStruct);
+}
+
+/// Alarm on the fields that are not negative, the others match anything
+int BM8563::SetAlarmIRQ(const BM8563_DateTypeDef &BM8563_DateStruct, const BM8563_TimeTypeDef &BM8563_TimeStruct) {
+  // bit 7 set disables a field
+  uint8_t buf[4] = {0x80, 0x80, 0x80, 0x80};
+  bool enable = false;
+  if (BM8563_TimeStruct.minutes >= 0) {
+    buf[0] = byteToBcd2(BM8563_TimeStruct.minutes) & 0x7f;
+    enable = true;
+  }
+  if (BM8563_TimeStruct.hours >= 0) {
+    buf[1] = byteToBcd2(BM8563_TimeStruct.hours) & 0x3f;
+    enable = true;
+  }
+  if (BM8563_DateStruct.day >= 0) {
+    buf[2] = byteToBcd2(BM8563_DateStruct.day) & 0x3f;
+    enable = true;
+  }
+  if (BM8563_DateStruct.week >= 0) {
+    buf[3] = byteToBcd2(BM8563_DateStruct.week) & 0x07;
+    enable = true;
+  }
+  this->write_register(0x09, buf, 4);
+
+  uint8_t reg_value = ReadReg(0x01);
+  if (enable) {
+    reg_value |= (1 << 1);
+  } else {
+    reg_value &= ~(1 << 1);
+  }
+  // stop the countdown timer, only the alarm may wake
+  reg_value &= ~(1 << 0);
+  WriteReg(0x01, reg_value);
+  WriteReg(0x0E, 0x03);
+  return enable ? 1 : 0;
+}
+
 void BM8563::clearIRQ() {
   uint8_t data = ReadReg(0x01);
   WriteReg(0x01, data & 0xf3);
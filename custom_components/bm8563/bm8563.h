@@ -3,6 +3,8 @@
 #include "esphome/components/sensor/sensor.h"
 #include "esphome/components/i2c/i2c.h"
 #include "esphome/components/time/real_time_clock.h"
+#include "esphome/core/preferences.h"
+#include <vector>
 
 namespace esphome {
 namespace bm8563 {
@@ -22,22 +24,46 @@ typedef struct
   int16_t year;
 } BM8563_DateTypeDef;
 
+/// A wall clock wake up in local time, hour -1 wakes every hour
+struct WakeTime {
+  int8_t hour;
+  uint8_t minute;
+};
+
 class BM8563 : public time::RealTimeClock, public i2c::I2CDevice {
   public:
     void setup() override;
     void update() override;
     void dump_config() override;
+    // before on_boot automations and the display, so they see the time and the wake reason
+    float get_setup_priority() const override { return setup_priority::HARDWARE + 1.0f; }
     
     void set_sleep_duration(uint32_t time_ms);
+    void set_resync_interval(uint32_t resync_interval) { this->resync_interval_ = resync_interval; }
     void write_time();
     void read_time();
+    /// Arm the next wake, the sooner of the sleep duration and the wake times
     void apply_sleep_duration();
+    void add_wake_time(int8_t hour, uint8_t minute) { this->wake_times_.push_back(WakeTime{hour, minute}); }
+
+    /// Wake in this many seconds, see schedule_wake_at()
+    bool schedule_wake(uint32_t seconds);
+    /** Wake at this UTC timestamp
+     *
+     * Up to 255 s ahead the countdown timer counts seconds. Further ahead the alarm registers match
+     * the minute, hour and day, on the minute at or after the target. Beyond 27 days the day would
+     * be ambiguous, the alarm goes off on the way and setup() arms the next link of the chain.
+     */
+    bool schedule_wake_at(uint32_t target);
+    /// Woken early on the way to a wake more than 27 days ahead, already re-armed
+    bool is_chained_wake() const { return this->chained_wake_; }
+    /// The timer or alarm flag was set at boot, the RTC powered the unit back on
+    bool is_alarm_wake() const { return this->alarm_wake_; }
 
   private:
     bool getVoltLow();
 
-    void getTime(BM8563_TimeTypeDef* BM8563_TimeStruct);
-    void getDate(BM8563_DateTypeDef* BM8563_DateStruct);
+    bool getDateTime(BM8563_DateTypeDef* BM8563_DateStruct, BM8563_TimeTypeDef* BM8563_TimeStruct);
 
     void setTime(BM8563_TimeTypeDef* BM8563_TimeStruct);
     void setDate(BM8563_DateTypeDef* BM8563_DateStruct);
@@ -46,6 +72,9 @@ class BM8563 : public time::RealTimeClock, public i2c::I2CDevice {
     int SetAlarmIRQ(const BM8563_TimeTypeDef &BM8563_TimeStruct);
     int SetAlarmIRQ(const BM8563_DateTypeDef &BM8563_DateStruct, const BM8563_TimeTypeDef &BM8563_TimeStruct);
 
+    optional<uint32_t> next_wake_time_(uint32_t now);
+    void store_wake_target_(uint32_t target);
+
     void clearIRQ();
     void disableIRQ();
 
@@ -57,9 +86,30 @@ class BM8563 : public time::RealTimeClock, public i2c::I2CDevice {
 
     uint8_t trdata[7];
     optional<uint32_t> sleep_duration_;
+    // the system clock runs on its own between reads, see update()
+    uint32_t resync_interval_{3600000};
+    uint32_t rtc_epoch_{0};
+    uint32_t rtc_read_ms_{0};
+
+    std::vector<WakeTime> wake_times_;
+    // final target of a chained wake, 0 when the armed alarm is the target itself
+    ESPPreferenceObject wake_pref_;
+    uint32_t wake_target_{0};
+    bool chained_wake_{false};
+    bool alarm_wake_{false};
     bool setupComplete;
 };
 
+template<typename... Ts> class IsAlarmWakeCondition : public Condition<Ts...>, public Parented<BM8563> {
+ public:
+  bool check(Ts... x) override { return this->parent_->is_alarm_wake(); }
+};
+
+template<typename... Ts> class IsChainedWakeCondition : public Condition<Ts...>, public Parented<BM8563> {
+ public:
+  bool check(Ts... x) override { return this->parent_->is_chained_wake(); }
+};
+
 template<typename... Ts> class WriteAction : public Action<Ts...>, public Parented<BM8563> {
  public:
   void play(Ts... x) override { this->parent_->write_time(); }
@@ -7,16 +7,33 @@ from esphome.const import CONF_ID, CONF_SLEEP_DURATION
 DEPENDENCIES = ['i2c']
 
 CONF_I2C_ADDR = 0x51
+CONF_RESYNC_INTERVAL = "resync_interval"
+CONF_WAKE_TIMES = "wake_times"
+CONF_HOUR = "hour"
+CONF_MINUTE = "minute"
 
 bm8563 = cg.esphome_ns.namespace('bm8563')
 BM8563 = bm8563.class_('BM8563', cg.Component, i2c.I2CDevice)
 WriteAction = bm8563.class_("WriteAction", automation.Action)
 ReadAction = bm8563.class_("ReadAction", automation.Action)
 SleepAction = bm8563.class_("SleepAction", automation.Action)
+IsAlarmWakeCondition = bm8563.class_("IsAlarmWakeCondition", automation.Condition)
+IsChainedWakeCondition = bm8563.class_("IsChainedWakeCondition", automation.Condition)
 
 CONFIG_SCHEMA = time.TIME_SCHEMA.extend({
     cv.GenerateID(): cv.declare_id(BM8563),
     cv.Optional(CONF_SLEEP_DURATION): cv.positive_time_period_milliseconds,
+    # the chip is read at boot and then only this often
+    cv.Optional(CONF_RESYNC_INTERVAL, default="1h"): cv.positive_time_period_milliseconds,
+    # local wall clock times, leaving out the hour wakes every hour
+    cv.Optional(CONF_WAKE_TIMES): cv.ensure_list(
+        cv.Schema(
+            {
+                cv.Optional(CONF_HOUR): cv.int_range(min=0, max=23),
+                cv.Required(CONF_MINUTE): cv.int_range(min=0, max=59),
+            }
+        )
+    ),
 }).extend(cv.COMPONENT_SCHEMA).extend(i2c.i2c_device_schema(CONF_I2C_ADDR))
 
 @automation.register_action(
@@ -61,10 +78,36 @@ async def bm8563_read_time_to_code(config, action_id, template_arg, args):
     await cg.register_parented(var, config[CONF_ID])
     return var
 
+@automation.register_condition(
+    "bm8563.is_alarm_wake",
+    IsAlarmWakeCondition,
+    automation.maybe_simple_id(
+        {
+            cv.GenerateID(): cv.use_id(BM8563),
+        }
+    ),
+)
+@automation.register_condition(
+    "bm8563.is_chained_wake",
+    IsChainedWakeCondition,
+    automation.maybe_simple_id(
+        {
+            cv.GenerateID(): cv.use_id(BM8563),
+        }
+    ),
+)
+async def bm8563_wake_condition_to_code(config, condition_id, template_arg, args):
+    var = cg.new_Pvariable(condition_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await i2c.register_i2c_device(var, config)
     await time.register_time(var, config)
+    cg.add(var.set_resync_interval(config[CONF_RESYNC_INTERVAL]))
     if CONF_SLEEP_DURATION in config:
         cg.add(var.set_sleep_duration(config[CONF_SLEEP_DURATION]))
+    for conf in config.get(CONF_WAKE_TIMES, []):
+        cg.add(var.add_wake_time(conf.get(CONF_HOUR, -1), conf[CONF_MINUTE]))
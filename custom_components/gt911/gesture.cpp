@@ -0,0 +1,161 @@
+#include "gesture.h"
+#include "esphome/core/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace esphome {
+namespace gt911 {
+
+static const char *const TAG = "gt911.gesture";
+
+// a pinch has to change the finger distance by more than this
+static const float PINCH_MIN_CHANGE = 0.1f;
+
+float GestureEngine::distance_(int dx, int dy) { return sqrtf(float(dx * dx + dy * dy)); }
+
+uint8_t GestureEngine::active_count() const {
+  uint8_t count = 0;
+  for (const auto &touch : this->touches_) {
+    if (touch.active)
+      count++;
+  }
+  return count;
+}
+
+/// Distance between the first two active fingers
+float GestureEngine::finger_distance_() const {
+  const TrackedTouch *first = nullptr;
+  for (const auto &touch : this->touches_) {
+    if (!touch.active)
+      continue;
+    if (first == nullptr) {
+      first = &touch;
+      continue;
+    }
+    return distance_(touch.x - first->x, touch.y - first->y);
+  }
+  return 0.0f;
+}
+
+void GestureEngine::update(const touchscreen::TouchPoint *points, uint8_t count, uint32_t now) {
+  for (auto &touch : this->touches_) {
+    touch.seen = false;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    const touchscreen::TouchPoint &point = points[i];
+    TrackedTouch *slot = nullptr;
+    TrackedTouch *free_slot = nullptr;
+    for (auto &touch : this->touches_) {
+      if (touch.active && touch.id == point.id) {
+        slot = &touch;
+        break;
+      }
+      if (!touch.active && free_slot == nullptr)
+        free_slot = &touch;
+    }
+
+    if (slot == nullptr) {
+      if (free_slot == nullptr)
+        continue;
+      // touch down
+      slot = free_slot;
+      slot->id = point.id;
+      slot->active = true;
+      slot->start_x = slot->x = point.x;
+      slot->start_y = slot->y = point.y;
+      slot->start_ms = now;
+    }
+    slot->x = point.x;
+    slot->y = point.y;
+    slot->seen = true;
+  }
+
+  uint8_t active = this->active_count();
+  if (active >= 2) {
+    if (!this->multi_touch_) {
+      this->multi_touch_ = true;
+      this->pinch_start_distance_ = this->finger_distance_();
+    }
+    this->pinch_distance_ = this->finger_distance_();
+  }
+
+  for (auto &touch : this->touches_) {
+    if (touch.active && !touch.seen)
+      this->touch_up_(touch, now);
+  }
+
+  if (this->active_count() == 0) {
+    // gesture over
+    this->multi_touch_ = false;
+    this->long_press_fired_ = false;
+  } else {
+    this->check_long_press(now);
+  }
+}
+
+void GestureEngine::check_long_press(uint32_t now) {
+  if (this->multi_touch_ || this->long_press_fired_)
+    return;
+  for (auto &touch : this->touches_) {
+    if (!touch.active)
+      continue;
+    if (now - touch.start_ms < this->long_press_time_)
+      return;
+    if (distance_(touch.x - touch.start_x, touch.y - touch.start_y) > this->tap_distance_)
+      return;
+    this->long_press_fired_ = true;
+    ESP_LOGD(TAG, "Long press at %d, %d", touch.x, touch.y);
+    this->long_press_callback_.call(touch.x, touch.y);
+    return;
+  }
+}
+
+void GestureEngine::touch_up_(TrackedTouch &touch, uint32_t now) {
+  touch.active = false;
+
+  if (this->multi_touch_) {
+    // the pinch ends with the first finger lifted, later ones are ignored
+    if (this->pinch_start_distance_ > 0.0f) {
+      float scale = this->pinch_distance_ / this->pinch_start_distance_;
+      if (fabsf(scale - 1.0f) > PINCH_MIN_CHANGE) {
+        ESP_LOGD(TAG, "Pinch, scale %.2f", scale);
+        this->pinch_callback_.call(scale);
+      }
+      this->pinch_start_distance_ = 0.0f;
+    }
+    return;
+  }
+  if (this->long_press_fired_)
+    return;
+
+  int dx = touch.x - touch.start_x;
+  int dy = touch.y - touch.start_y;
+  float distance = distance_(dx, dy);
+  uint32_t duration = now - touch.start_ms;
+
+  if (distance <= this->tap_distance_) {
+    if (duration < this->long_press_time_) {
+      ESP_LOGD(TAG, "Tap at %d, %d", touch.x, touch.y);
+      this->tap_callback_.call(touch.x, touch.y);
+    }
+    return;
+  }
+
+  if (distance >= this->swipe_distance_ && duration <= this->swipe_time_) {
+    SwipeDirection direction;
+    if (abs(dx) >= abs(dy)) {
+      direction = dx < 0 ? SWIPE_LEFT : SWIPE_RIGHT;
+    } else {
+      direction = dy < 0 ? SWIPE_UP : SWIPE_DOWN;
+    }
+    float velocity = distance * 1000.0f / std::max<uint32_t>(duration, 1);
+    ESP_LOGD(TAG, "Swipe %u, %.0f px/s", direction, velocity);
+    this->swipe_callback_.call(direction, velocity);
+  }
+}
+
+}  // namespace gt911
+}  // namespace esphome
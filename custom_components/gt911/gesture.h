@@ -0,0 +1,89 @@
+#pragma once
+
+#include "esphome/core/helpers.h"
+#include "esphome/components/touchscreen/touchscreen.h"
+
+namespace esphome {
+namespace gt911 {
+
+static const uint8_t GESTURE_MAX_TOUCHES = 5;
+
+enum SwipeDirection : uint8_t {
+  SWIPE_LEFT,
+  SWIPE_RIGHT,
+  SWIPE_UP,
+  SWIPE_DOWN,
+};
+
+/// One finger, followed by its track id from touch down to touch up
+struct TrackedTouch {
+  uint8_t id;
+  bool active;
+  bool seen;
+  int16_t start_x;
+  int16_t start_y;
+  int16_t x;
+  int16_t y;
+  uint32_t start_ms;
+};
+
+/** Turns the points of every touch report into gestures.
+ *
+ * Fingers are matched to earlier ones by their track id. A gesture starts
+ * with the first finger down and ends when the last one is lifted. One
+ * finger gives a tap, a long press or a swipe, two fingers a pinch. All
+ * coordinates are display coordinates.
+ */
+class GestureEngine {
+ public:
+  /// Feed the points of one report, fingers missing from it are lifted.
+  void update(const touchscreen::TouchPoint *points, uint8_t count, uint32_t now);
+  /// All fingers are lifted.
+  void release(uint32_t now) { this->update(nullptr, 0, now); }
+  /// Fire a long press once the finger is held long enough, even without new reports.
+  void check_long_press(uint32_t now);
+
+  void set_tap_distance(uint16_t tap_distance) { tap_distance_ = tap_distance; }
+  void set_long_press_time(uint32_t long_press_time) { long_press_time_ = long_press_time; }
+  void set_swipe_distance(uint16_t swipe_distance) { swipe_distance_ = swipe_distance; }
+  void set_swipe_time(uint32_t swipe_time) { swipe_time_ = swipe_time; }
+
+  void add_on_tap_callback(std::function<void(int, int)> &&callback) { tap_callback_.add(std::move(callback)); }
+  void add_on_long_press_callback(std::function<void(int, int)> &&callback) {
+    long_press_callback_.add(std::move(callback));
+  }
+  /// Called with the direction and the speed in pixels per second
+  void add_on_swipe_callback(std::function<void(SwipeDirection, float)> &&callback) {
+    swipe_callback_.add(std::move(callback));
+  }
+  /// Called with the ratio of the final to the initial finger distance
+  void add_on_pinch_callback(std::function<void(float)> &&callback) { pinch_callback_.add(std::move(callback)); }
+
+  uint8_t active_count() const;
+
+ protected:
+  void touch_up_(TrackedTouch &touch, uint32_t now);
+  static float distance_(int dx, int dy);
+  float finger_distance_() const;
+
+  TrackedTouch touches_[GESTURE_MAX_TOUCHES]{};
+
+  // state of the gesture in progress
+  bool multi_touch_{false};
+  bool long_press_fired_{false};
+  float pinch_start_distance_{0.0f};
+  float pinch_distance_{0.0f};
+
+  uint16_t tap_distance_{20};
+  uint32_t long_press_time_{500};
+  uint16_t swipe_distance_{80};
+  uint32_t swipe_time_{1000};
+
+  CallbackManager<void(int, int)> tap_callback_;
+  CallbackManager<void(int, int)> long_press_callback_;
+  CallbackManager<void(SwipeDirection, float)> swipe_callback_;
+  CallbackManager<void(float)> pinch_callback_;
+};
+
+}  // namespace gt911
+}  // namespace esphome
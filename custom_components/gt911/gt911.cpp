@@ -2,14 +2,24 @@
 #include "esphome/components/i2c/i2c_bus.h"
 #include "gt911.h"
 #include <Wire.h>
+#ifdef USE_ESP32
+#include <esp_sleep.h>
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace esphome {
 namespace gt911 {
 
 static const char *TAG = "gt911.sensor";
 
+// config bytes per I2C transfer, well below the Wire buffer size
+static const uint8_t GT911_CONFIG_CHUNK = 32;
+
 void IRAM_ATTR HOT GT911TouchscreenStore::gpio_intr(GT911TouchscreenStore *store) {
-  store->touch = true;
+  // a full ring means the loop is behind, the newer reports overwrite the controller buffer anyway
+  store->interrupts.push(micros());
 }
 
 void GT911::setup(){
@@ -22,127 +32,332 @@ void GT911::setup(){
     return;
   }
 
+  if (this->read_config_()) {
+    this->apply_config_();
+  } else {
+    ESP_LOGW(TAG, "Failed to read config");
+  }
+
+#ifdef USE_ESP32
+  esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  if (cause == ESP_SLEEP_WAKEUP_EXT0 || cause == ESP_SLEEP_WAKEUP_EXT1) {
+    // the controller may still be in gesture mode from before the deep sleep, the automations
+    // only get the gesture once everything is set up
+    this->low_power_ = true;
+    this->defer([this]() { this->read_wake_gesture_(); });
+  }
+#endif
+
+  // x runs along the display height when rotated by 90 or 270 degrees, see parse_report_()
+  bool swapped = this->rotation_ == ROTATE_90_DEGREES || this->rotation_ == ROTATE_270_DEGREES;
+  uint16_t width = swapped ? this->display_height_ : this->display_width_;
+  uint16_t height = swapped ? this->display_width_ : this->display_height_;
+  this->filter_.set_max(width, height);
+
+  if (this->touch_index_.size() > 0) {
+    this->touch_index_.build(width, height);
+    // the indexed listeners registered themselves too, they must not get every touch twice
+    auto &listeners = this->touch_listeners_;
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                   [this](TouchListener *listener) { return this->touch_index_.contains(listener); }),
+                    listeners.end());
+  }
+
   this->store_.pin = this->interrupt_pin_->to_isr();
   this->interrupt_pin_->attach_interrupt(GT911TouchscreenStore::gpio_intr, &this->store_,
                                           gpio::INTERRUPT_FALLING_EDGE);
 }
 
 void GT911::loop(){
-  const bool touched = this->store_.touch;
-  if (!touched)
+  uint32_t interrupt_us;
+  bool pending = false;
+  // the controller only holds the latest report, one read covers every queued interrupt
+  while (this->store_.interrupts.pop(interrupt_us)) {
+    pending = true;
+  }
+  if (pending) {
+    if (this->low_power_) {
+      this->read_wake_gesture_();
+    } else {
+      this->read_touches_(interrupt_us);
+    }
+  }
+
+  this->process_samples_();
+  this->gestures_.check_long_press(millis());
+}
+
+void GT911::enter_low_power() {
+  uint8_t command = GT911_COMMAND_GESTURE;
+  // the command only takes with the same value in the check register
+  if (this->write_register16(GT911_COMMAND_CHECK, &command, 1) != i2c::ERROR_OK ||
+      this->write_register16(GT911_COMMAND, &command, 1) != i2c::ERROR_OK) {
+    ESP_LOGW(TAG, "Failed to enter gesture mode");
     return;
+  }
+  this->low_power_ = true;
+  this->filter_.reset();
+  this->high_freq_.stop();
+#ifdef USE_ESP32
+  // a gesture pulls INT low
+  esp_sleep_enable_ext0_wakeup(static_cast<gpio_num_t>(this->interrupt_pin_->get_pin()), 0);
+#endif
+  ESP_LOGD(TAG, "Entered gesture mode");
+}
 
-  this->store_.touch = false;
+/// Fetch the gesture that woke the controller, restore normal mode and report it
+void GT911::read_wake_gesture_() {
+  uint8_t gesture = 0;
+  if (this->read_register16(GT911_GESTURE_ID, &gesture, 1, false) != i2c::ERROR_OK) {
+    ESP_LOGW(TAG, "Failed to read wake gesture");
+  }
+  this->exit_low_power_();
+  if (gesture != 0) {
+    ESP_LOGD(TAG, "Woken by gesture 0x%02X", gesture);
+    this->wake_gesture_callback_.call(gesture);
+  }
+}
+
+void GT911::exit_low_power_() {
+  uint8_t zero = 0;
+  this->write_register16(GT911_GESTURE_ID, &zero, 1);
+  uint8_t command = GT911_COMMAND_READ_COORDINATES;
+  this->write_register16(GT911_COMMAND, &command, 1);
+  // drop any report left from before the gesture
+  this->write_register16(GT911_POINT_INFO, &zero, 1);
+  this->low_power_ = false;
+#ifdef USE_ESP32
+  // touches in normal mode must not wake the next deep sleep
+  esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_EXT0);
+#endif
+}
 
-  uint8_t pointInfo = this->readByteData(GT911_POINT_INFO);
-  uint8_t touches = pointInfo & 0x0F;
+/** Read the current report into the sample ring, stamped with the time of its interrupt
+ *
+ * The status byte and all point records are read in one burst from 0x814E, the register address is
+ * followed by a repeated start instead of a stop. Clearing the status is the only other transfer.
+ */
+void GT911::read_touches_(uint32_t interrupt_us) {
+  // status byte followed by one 8 byte record per point, each record starts with the track id
+  uint8_t data[1 + GESTURE_MAX_TOUCHES * 8];
+  if (this->read_register16(GT911_POINT_INFO, data, sizeof(data), false) != i2c::ERROR_OK) {
+    ESP_LOGW(TAG, "Failed to read touch report");
+    return;
+  }
 
-  if (touches == 0) {
-    for (auto *listener : this->touch_listeners_) {
-      listener->release();
-    }
-    this->writeByteData(GT911_POINT_INFO, 0);
+  uint32_t read_us = micros();
+  if (!(data[0] & 0x80)) {
+    // no new report
+    return;
+  }
+  uint8_t zero = 0;
+  this->write_register16(GT911_POINT_INFO, &zero, 1);
+
+  this->parse_report_(data, interrupt_us, read_us);
+}
+
+void GT911::inject_report(const uint8_t *report) {
+  uint32_t now = micros();
+  this->parse_report_(report, now, now);
+}
+
+/// Turn a raw report into a rotated sample and queue it
+void GT911::parse_report_(const uint8_t *data, uint32_t interrupt_us, uint32_t read_us) {
+  uint8_t pointInfo = data[0];
+  if (!(pointInfo & 0x80)) {
     return;
   }
 
-  bool isTouched = touches > 0;
-  if (pointInfo & 0x80) {
-    if (isTouched) {
-      TouchPoint tp;
-      uint8_t data[touches * 8] = {0};
-      if (!this->readBlockData(data, 0x8150, touches * 8)) {
-        ESP_LOGE(TAG, "Failed to read block data");
-        return;
+  TouchSample sample;
+  sample.time_ms = millis() - (micros() - interrupt_us) / 1000;
+  sample.interrupt_us = interrupt_us;
+  sample.read_us = read_us;
+  sample.count = std::min<uint8_t>(pointInfo & 0x0F, GESTURE_MAX_TOUCHES);
+
+  if (sample.count > 0) {
+    for (int i = 0; i < sample.count; i++) {
+      const uint8_t *buf = data + 1 + i * 8;
+      TouchPoint &tp = sample.points[i];
+
+      uint16_t dimension_one = (buf[4] << 8) | buf[3];
+      uint16_t dimension_two = (buf[2] << 8) | buf[1];
+      tp.id = buf[0];
+
+      switch (this->rotation_){
+        case ROTATE_0_DEGREES:
+          tp.x = dimension_one;
+          tp.y = this->display_height_ - dimension_two;
+          break;
+        case ROTATE_180_DEGREES:
+          tp.x = this->display_width_ - dimension_one;
+          tp.y = dimension_two;
+          break;
+        case ROTATE_270_DEGREES:
+          tp.x = dimension_two;
+          tp.y = dimension_one;
+          break;
+        case ROTATE_90_DEGREES:
+          tp.x = this->display_height_ - dimension_two;
+          tp.y = this->display_width_ - dimension_one;
+          break;
+        default:
+          break;
       }
+      ESP_LOGV(TAG, "TOUCH %i, ID: %i X: %i Y:%i ONE %i, TWO %i, ROT: %i", i, tp.id, tp.x, tp.y, dimension_one,
+               dimension_two, this->rotation_);
+    }
+  }
 
-      for (int i = 0; i < touches; i++) {
-        uint8_t *buf = data + i * 8;
-
-        uint16_t dimension_one = (buf[3] << 8) | buf[2];
-        uint16_t dimension_two = (buf[1] << 8) | buf[0];
-
-        switch (this->rotation_){
-          case ROTATE_0_DEGREES:
-            tp.x = dimension_one;
-            tp.y = this->display_height_ - dimension_two;
-            break;
-          case ROTATE_180_DEGREES:
-            tp.x = this->display_width_ - dimension_one;
-            tp.y = dimension_two;
-            break;
-          case ROTATE_270_DEGREES:
-            tp.x = dimension_two;
-            tp.y = dimension_one;
-            break;
-          case ROTATE_90_DEGREES:
-            tp.x = this->display_height_ - dimension_two;
-            tp.y = this->display_width_ - dimension_one;
-            break;
-          default:
-            break;
-        }
-        ESP_LOGE(TAG, "TOUCH %i, X: %i Y:%i ONE %i, TWO %i, ROT: %i", i, tp.x, tp.y, dimension_one, dimension_two, this->rotation_);
-
-        this->defer([this, tp]() { this->send_touch_(tp); });
+  if (!this->samples_.push(sample)) {
+    ESP_LOGW(TAG, "Touch samples overflowed");
+  }
+}
 
+/// Hand every queued sample to the listeners and the gesture engine
+void GT911::process_samples_() {
+  TouchSample sample;
+  while (this->samples_.pop(sample)) {
+    if (sample.count == 0) {
+      this->filter_.reset();
+      this->gestures_.release(sample.time_ms);
+      for (auto *listener : this->touch_listeners_) {
+        listener->release();
       }
+      this->touch_index_.release();
+      this->high_freq_.stop();
+      continue;
+    }
+
+    this->high_freq_.start();
+    // gestures measure the raw strokes, the listeners get the filtered and predicted points
+    this->gestures_.update(sample.points, sample.count, sample.time_ms);
+    if (this->filter_enabled_) {
+      this->filter_.apply(sample.points, sample.count, sample.time_ms);
+    }
+    for (uint8_t i = 0; i < sample.count; i++) {
+      this->send_touch_(sample.points[i]);
     }
+    this->touch_index_.touch(sample.points, sample.count);
+#ifdef USE_GT911_LATENCY
+    if (this->latency_tracer_ != nullptr) {
+      this->latency_tracer_->touch(sample.interrupt_us, sample.read_us, micros());
+    }
+#endif
   }
-  this->writeByteData(GT911_POINT_INFO, 0);
 }
 
 void GT911::dump_config(){
   ESP_LOGCONFIG(TAG, "GT911:");
   ESP_LOGCONFIG(TAG, "  Address: 0x%02X", this->address_);
+  ESP_LOGCONFIG(TAG, "  Indexed Listeners: %u", this->touch_index_.size());
+  if (this->config_read_) {
+    ESP_LOGCONFIG(TAG, "  Config Version: 0x%02X", this->config_[0]);
+    ESP_LOGCONFIG(TAG, "  Report Rate: %u Hz",
+                  1000u / (5u + (this->config_[GT911_REFRESH_RATE - GT911_CONFIG_START] & 0x0F)));
+    ESP_LOGCONFIG(TAG, "  Touch Number: %u", this->config_[GT911_TOUCH_NUMBER - GT911_CONFIG_START] & 0x0F);
+    ESP_LOGCONFIG(TAG, "  Touch/Release Threshold: %u/%u",
+                  this->config_[GT911_SCREEN_TOUCH_LEVEL - GT911_CONFIG_START],
+                  this->config_[GT911_SCREEN_RELEASE_LEVEL - GT911_CONFIG_START]);
+  }
 }
 
-void GT911::calculate_checksum() {
+static uint8_t config_checksum(const uint8_t *config) {
   uint8_t checksum = 0;
-  for (uint8_t i=0; i<GT911_CONFIG_SIZE; i++) {
-    checksum += configBuf[i];
+  for (uint16_t i = 0; i < GT911_CONFIG_SIZE; i++) {
+    checksum += config[i];
   }
-  checksum = (~checksum) + 1;
-  configBuf[GT911_CONFIG_CHKSUM - GT911_CONFIG_START] = checksum;
+  return (~checksum) + 1;
 }
 
-void GT911::reflashConfig() {
-  this->calculate_checksum();
-  this->writeByteData(GT911_CONFIG_CHKSUM, configBuf[GT911_CONFIG_CHKSUM-GT911_CONFIG_START]);
-  this->writeByteData(GT911_CONFIG_FRESH, 1);
+void GT911::set_report_rate(float report_rate) {
+  // the controller reports every 5 + N ms, N being the low nibble of 0x8056
+  this->report_period_ = clamp<int>(lroundf(1000.0f / report_rate), 5, 20);
+  if (this->config_read_) {
+    this->apply_config_();
+  }
 }
 
-void GT911::setResolution(uint16_t _width, uint16_t _height) {
-  configBuf[GT911_X_OUTPUT_MAX_LOW - GT911_CONFIG_START] = lowByte(_width);
-  configBuf[GT911_X_OUTPUT_MAX_HIGH - GT911_CONFIG_START] = highByte(_width);
-  configBuf[GT911_Y_OUTPUT_MAX_LOW - GT911_CONFIG_START] = lowByte(_height);
-  configBuf[GT911_Y_OUTPUT_MAX_HIGH - GT911_CONFIG_START] = highByte(_height);
-  this->reflashConfig();
+void GT911::set_gesture_report_rate(float report_rate) {
+  // same 5 + N ms period as the normal report rate
+  this->gesture_period_ = clamp<int>(lroundf(1000.0f / report_rate), 5, 20);
 }
 
-void GT911::writeByteData(uint16_t reg, uint8_t val) {
-  this->write_byte_16(highByte(reg), lowByte(reg) << 8 | val);
+bool GT911::read_config_() {
+  // a torn read is retried once, a config that still doesn't match is never written back
+  for (uint8_t attempt = 0; attempt < 2; attempt++) {
+    // the Wire buffers can't take the whole config, read it in chunks
+    for (uint16_t offset = 0; offset < GT911_CONFIG_SIZE; offset += GT911_CONFIG_CHUNK) {
+      uint8_t len = std::min<uint16_t>(GT911_CONFIG_CHUNK, GT911_CONFIG_SIZE - offset);
+      if (this->read_register16(GT911_CONFIG_START + offset, this->config_ + offset, len, false) != i2c::ERROR_OK) {
+        return false;
+      }
+    }
+    uint8_t checksum;
+    if (this->read_register16(GT911_CONFIG_CHKSUM, &checksum, 1, false) != i2c::ERROR_OK) {
+      return false;
+    }
+    if (checksum == config_checksum(this->config_)) {
+      this->config_read_ = true;
+      return true;
+    }
+    ESP_LOGW(TAG, "Config checksum mismatch, 0x%02X instead of 0x%02X", checksum, config_checksum(this->config_));
+  }
+  return false;
 }
 
-uint8_t GT911::readByteData(uint16_t reg) {
-  uint8_t x;
-  this->write_byte(highByte(reg), lowByte(reg));
-  uint8_t data;
-  this->read(&data, 1);
-  return data;
+bool GT911::write_config_() {
+  for (uint16_t offset = 0; offset < GT911_CONFIG_SIZE; offset += GT911_CONFIG_CHUNK) {
+    uint8_t len = std::min<uint16_t>(GT911_CONFIG_CHUNK, GT911_CONFIG_SIZE - offset);
+    if (this->write_register16(GT911_CONFIG_START + offset, this->config_ + offset, len) != i2c::ERROR_OK) {
+      return false;
+    }
+  }
+  // checksum and fresh flag go last, the controller only takes the config once the flag is set
+  uint8_t tail[2] = {config_checksum(this->config_), 1};
+  return this->write_register16(GT911_CONFIG_CHKSUM, tail, sizeof(tail)) == i2c::ERROR_OK;
 }
 
-void GT911::writeBlockData(uint16_t reg, uint8_t *val, uint8_t size) {
-  this->write((uint8_t*)&reg, 2);
-  this->write(val, size);
-}
+void GT911::apply_config_() {
+  uint8_t config[GT911_CONFIG_SIZE];
+  memcpy(config, this->config_, GT911_CONFIG_SIZE);
 
-bool GT911::readBlockData(uint8_t *buf, uint16_t reg, uint8_t size) {
-  esphome::i2c::ErrorCode e;
-  if(!this->write_byte(highByte(reg), lowByte(reg))){
-    return false;
+  if (this->report_period_.has_value()) {
+    uint8_t &reg = config[GT911_REFRESH_RATE - GT911_CONFIG_START];
+    reg = (reg & 0xF0) | (*this->report_period_ - 5);
+  }
+  if (this->touch_number_.has_value()) {
+    uint8_t &reg = config[GT911_TOUCH_NUMBER - GT911_CONFIG_START];
+    reg = (reg & 0xF0) | *this->touch_number_;
+  }
+  if (this->touch_threshold_.has_value()) {
+    config[GT911_SCREEN_TOUCH_LEVEL - GT911_CONFIG_START] = *this->touch_threshold_;
+  }
+  if (this->release_threshold_.has_value()) {
+    config[GT911_SCREEN_RELEASE_LEVEL - GT911_CONFIG_START] = *this->release_threshold_;
+  }
+  if (this->move_threshold_.has_value()) {
+    config[GT911_X_THRESHOLD - GT911_CONFIG_START] = *this->move_threshold_;
+    config[GT911_Y_THRESHOLD - GT911_CONFIG_START] = *this->move_threshold_;
+  }
+  if (this->gesture_period_.has_value()) {
+    uint8_t &reg = config[GT911_GESTURE_REFRESH_RATE - GT911_CONFIG_START];
+    reg = (reg & 0xF0) | (*this->gesture_period_ - 5);
+    // every wake gesture the controller knows
+    config[GT911_GESTURE_SWITCH1 - GT911_CONFIG_START] = 0xFF;
+    config[GT911_GESTURE_SWITCH2 - GT911_CONFIG_START] = 0xFF;
+  }
+
+  // every upload goes to the controller flash, skip it when nothing changed
+  if (memcmp(config, this->config_, GT911_CONFIG_SIZE) == 0) {
+    ESP_LOGD(TAG, "Config unchanged");
+    return;
+  }
+  memcpy(this->config_, config, GT911_CONFIG_SIZE);
+  if (!this->write_config_()) {
+    ESP_LOGW(TAG, "Failed to write config");
+    return;
   }
-  e = this->read(buf, size);
-  return e == esphome::i2c::ERROR_OK;
+  ESP_LOGD(TAG, "Config written");
 }
 
 }  // namespace gt911
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "esphome/core/automation.h"
 #include "esphome/core/component.h"
 #include "esphome/components/i2c/i2c.h"
 #include "esphome/components/touchscreen/touchscreen.h"
+#include "gesture.h"
+#include "touch_ring.h"
+#include "touch_filter.h"
+#include "touch_index.h"
+#include "latency_tracer.h"
 
 #define GT911_ADDR1 (uint8_t)0x5D
 #define GT911_ADDR2 (uint8_t)0x14
@@ -12,6 +18,10 @@
 #define GT911_ESD_CHECK     (uint16_t)0x8041
 #define GT911_COMMAND_CHECK (uint16_t)0x8046
 
+// Real-time commands
+#define GT911_COMMAND_READ_COORDINATES (uint8_t)0x00
+#define GT911_COMMAND_GESTURE          (uint8_t)0x08
+
 // Configuration information (R/W)
 #define GT911_CONFIG_START             (uint16_t)0x8047
 #define GT911_CONFIG_VERSION           (uint16_t)0x8047
@@ -112,7 +122,10 @@
 #define GT911_DRIVER_CH0               (uint16_t)0X80D5
 #define GT911_CONFIG_CHKSUM            (uint16_t)0X80FF
 #define GT911_CONFIG_FRESH             (uint16_t)0X8100
-#define GT911_CONFIG_SIZE              (uint16_t)0xFF-0x46
+// every config byte before the checksum, the checksum covers exactly these
+#define GT911_CONFIG_SIZE              (uint16_t)(GT911_CONFIG_CHKSUM - GT911_CONFIG_START)
+// Gesture information, valid after a wake from gesture mode
+#define GT911_GESTURE_ID        (uint16_t)0x814B
 // Coordinate information
 #define GT911_PRODUCT_ID        (uint16_t)0X8140
 #define GT911_FIRMWARE_VERSION  (uint16_t)0X8140
@@ -139,11 +152,9 @@ namespace gt911 {
 using namespace touchscreen;
 
 struct GT911TouchscreenStore {
-  volatile bool touch;
+  // time of every interrupt, in micros, until the loop picks it up
+  TouchRing<uint32_t, 8> interrupts;
   ISRInternalGPIOPin pin;
-  uint32_t filter_us{0};
-  volatile uint32_t last_pulse{0};
-  volatile uint32_t last_accepted_window{0};
 
   static void gpio_intr(GT911TouchscreenStore *store);
 };
@@ -156,23 +167,138 @@ class GT911 : public Touchscreen, public Component, public i2c::I2CDevice {
 
     void set_interrupt_pin(InternalGPIOPin *pin) { this->interrupt_pin_ = pin; }
 
+    void set_touch_number(uint8_t touch_number) { this->touch_number_ = touch_number; }
+    void set_touch_threshold(uint8_t touch_threshold) { this->touch_threshold_ = touch_threshold; }
+    void set_release_threshold(uint8_t release_threshold) { this->release_threshold_ = release_threshold; }
+    void set_move_threshold(uint8_t move_threshold) { this->move_threshold_ = move_threshold; }
+    /// Scan rate in Hz while in gesture mode
+    void set_gesture_report_rate(float report_rate);
+    /// Report rate in Hz, the controller supports 50 to 200. Uploaded right away once set up.
+    void set_report_rate(float report_rate);
+
+    /** Feed a recorded report through the same path as one read from the controller
+     *
+     * report holds the status byte and the point records as read from 0x814E, the interrupt is
+     * taken to be now. Lets touch traces be replayed without a finger on the glass.
+     */
+    void inject_report(const uint8_t *report);
+#ifdef USE_GT911_LATENCY
+    void set_latency_tracer(LatencyTracer *tracer) { this->latency_tracer_ = tracer; }
+#endif
+
+    /** Put the controller into gesture mode, it only scans for wake gestures at a low rate.
+     *
+     * The interrupt line is armed as ext0 wake source of the ESP32. The next gesture, right away or
+     * after deep sleep, restores normal mode and is handed to the wake gesture callbacks.
+     */
+    void enter_low_power();
+    /// Called with the raw gesture id, 0xCC for a double tap, 0xAA/0xBB/0xBA/0xAB for swipes
+    void add_on_wake_gesture_callback(std::function<void(uint8_t)> &&callback) {
+      this->wake_gesture_callback_.add(std::move(callback));
+    }
+
+    /// Dispatch to this listener only for touches in its rectangle, in touch coordinates
+    void add_indexed_listener(TouchListener *listener, int16_t x_min, int16_t x_max, int16_t y_min, int16_t y_max) {
+      this->touch_index_.add(listener, x_min, x_max, y_min, y_max);
+    }
+
+    GestureEngine *get_gestures() { return &this->gestures_; }
+    /// Smooth and predict the points handed to the touch listeners
+    TouchFilter *enable_filter() {
+      this->filter_enabled_ = true;
+      return &this->filter_;
+    }
+
   protected:
+    void read_touches_(uint32_t interrupt_us);
+    void parse_report_(const uint8_t *data, uint32_t interrupt_us, uint32_t read_us);
+    void process_samples_();
+
+    void read_wake_gesture_();
+    void exit_low_power_();
+
+    bool read_config_();
+    bool write_config_();
+    /// Merge the requested settings into the config and upload it when anything changed
+    void apply_config_();
+
     InternalGPIOPin *interrupt_pin_;
     GT911TouchscreenStore store_;
+    // reports read from the controller, waiting for the listeners and gestures
+    TouchRing<TouchSample, 8> samples_;
+    GestureEngine gestures_;
+    TouchFilter filter_;
+    bool filter_enabled_{false};
+    TouchIndex touch_index_;
+    // poll the interrupt ring every loop while a finger is down
+    HighFrequencyLoopRequester high_freq_;
+#ifdef USE_GT911_LATENCY
+    LatencyTracer *latency_tracer_{nullptr};
+#endif
+
+    // config as read from the controller, only valid after setup
+    uint8_t config_[GT911_CONFIG_SIZE];
+    bool config_read_{false};
+    // report period in ms
+    optional<uint8_t> report_period_;
+    optional<uint8_t> touch_number_;
+    optional<uint8_t> touch_threshold_;
+    optional<uint8_t> release_threshold_;
+    optional<uint8_t> move_threshold_;
+    optional<uint8_t> gesture_period_;
 
-  private:
+    bool low_power_{false};
+    CallbackManager<void(uint8_t)> wake_gesture_callback_;
+};
+
+template<typename... Ts> class SetReportRateAction : public Action<Ts...>, public Parented<GT911> {
+ public:
+  TEMPLATABLE_VALUE(float, report_rate)
+
+  void play(Ts... x) override { this->parent_->set_report_rate(this->report_rate_.value(x...)); }
+};
+
+template<typename... Ts> class EnterLowPowerAction : public Action<Ts...>, public Parented<GT911> {
+ public:
+  void play(Ts... x) override { this->parent_->enter_low_power(); }
+};
 
+class WakeGestureTrigger : public Trigger<uint8_t> {
+ public:
+  explicit WakeGestureTrigger(GT911 *parent) {
+    parent->add_on_wake_gesture_callback([this](uint8_t gesture) { this->trigger(gesture); });
+  }
+};
+
+class TapTrigger : public Trigger<int, int> {
+ public:
+  explicit TapTrigger(GT911 *parent) {
+    parent->get_gestures()->add_on_tap_callback([this](int x, int y) { this->trigger(x, y); });
+  }
+};
 
-    void calculate_checksum();
-    void reflashConfig();
-    void setResolution(uint16_t _width, uint16_t _height);
-    void readTouches(void);
-    void writeByteData(uint16_t reg, uint8_t val);
-    uint8_t readByteData(uint16_t reg);
-    void writeBlockData(uint16_t reg, uint8_t *val, uint8_t size);
-    bool readBlockData(uint8_t *buf, uint16_t reg, uint8_t size);
+class LongPressTrigger : public Trigger<int, int> {
+ public:
+  explicit LongPressTrigger(GT911 *parent) {
+    parent->get_gestures()->add_on_long_press_callback([this](int x, int y) { this->trigger(x, y); });
+  }
+};
+
+class SwipeTrigger : public Trigger<float> {
+ public:
+  SwipeTrigger(GT911 *parent, SwipeDirection direction) {
+    parent->get_gestures()->add_on_swipe_callback([this, direction](SwipeDirection swiped, float velocity) {
+      if (swiped == direction)
+        this->trigger(velocity);
+    });
+  }
+};
 
-    uint8_t configBuf[GT911_CONFIG_SIZE];
+class PinchTrigger : public Trigger<float> {
+ public:
+  explicit PinchTrigger(GT911 *parent) {
+    parent->get_gestures()->add_on_pinch_callback([this](float scale) { this->trigger(scale); });
+  }
 };
 
 }  // namespace gt911
@@ -0,0 +1,110 @@
+#include "latency_tracer.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#ifdef USE_GT911_LATENCY
+
+#include <algorithm>
+#include <cmath>
+
+namespace esphome {
+namespace gt911 {
+
+static const char *const TAG = "gt911.latency";
+
+// a trace the display never picked up is dropped after this long
+static const uint32_t TRACE_TIMEOUT_US = 5000000;
+
+static const char *const STAGE_NAMES[LATENCY_STAGE_COUNT] = {"Read", "Dispatch", "Update Start", "Upload Done",
+                                                             "LUT Done"};
+
+std::function<void(uint8_t, uint32_t)> LatencyTracer::display_stage_callback() {
+  return [this](uint8_t stage, uint32_t time_us) {
+    // the display stages follow the touch stages in the same order
+    if (stage < LATENCY_STAGE_COUNT - LATENCY_STAGE_UPDATE_START) {
+      this->mark(static_cast<LatencyStage>(LATENCY_STAGE_UPDATE_START + stage), time_us);
+    }
+  };
+}
+
+void LatencyTracer::touch(uint32_t interrupt_us, uint32_t read_us, uint32_t dispatch_us) {
+  if (this->open_ && dispatch_us - this->interrupt_us_ < TRACE_TIMEOUT_US) {
+    // the first touch before an update is the one the user waits for
+    return;
+  }
+  this->open_ = true;
+  this->interrupt_us_ = interrupt_us;
+  std::fill(this->stages_us_, this->stages_us_ + LATENCY_STAGE_COUNT, 0);
+  this->stages_us_[LATENCY_STAGE_READ] = read_us;
+  this->stages_us_[LATENCY_STAGE_DISPATCH] = dispatch_us;
+}
+
+void LatencyTracer::mark(LatencyStage stage, uint32_t time_us) {
+  if (!this->open_ || this->stages_us_[stage] != 0) {
+    return;
+  }
+  // later stages only count for the update that started after the touch
+  if (stage != LATENCY_STAGE_UPDATE_START && this->stages_us_[LATENCY_STAGE_UPDATE_START] == 0) {
+    return;
+  }
+  this->stages_us_[stage] = time_us;
+  if (stage != LATENCY_STAGE_LUT_DONE) {
+    return;
+  }
+
+  uint32_t *trace = this->history_[this->history_index_];
+  for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+    trace[i] = this->stages_us_[i] == 0 ? 0 : this->stages_us_[i] - this->interrupt_us_;
+  }
+  this->history_index_ = (this->history_index_ + 1) % HISTORY;
+  this->history_count_ = std::min<uint8_t>(this->history_count_ + 1, HISTORY);
+  this->open_ = false;
+  ESP_LOGV(TAG, "Touch to pixel in %.1f ms", trace[LATENCY_STAGE_LUT_DONE] / 1000.0f);
+}
+
+float LatencyTracer::percentile(LatencyStage stage, uint8_t percentile) {
+  uint32_t values[HISTORY];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < this->history_count_; i++) {
+    // an upload stage is missing when the frame came from a cached page
+    if (this->history_[i][stage] != 0) {
+      values[count++] = this->history_[i][stage];
+    }
+  }
+  if (count == 0) {
+    return NAN;
+  }
+  uint8_t rank = std::min<uint8_t>((count * percentile + 99) / 100, count) - 1;
+  std::nth_element(values, values + rank, values + count);
+  return values[rank] / 1000.0f;
+}
+
+void LatencyTracer::log_latency() {
+  ESP_LOGI(TAG, "Touch latency over %u traces, p50/p90/p99 in ms:", this->history_count_);
+  for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+    auto stage = static_cast<LatencyStage>(i);
+    ESP_LOGI(TAG, "  %-12s %7.1f %7.1f %7.1f", STAGE_NAMES[i], this->percentile(stage, 50),
+             this->percentile(stage, 90), this->percentile(stage, 99));
+  }
+}
+
+void LatencyTracer::update() {
+  for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+    if (this->sensors_[i] != nullptr) {
+      this->sensors_[i]->publish_state(this->percentile(static_cast<LatencyStage>(i), this->percentile_));
+    }
+  }
+}
+
+void LatencyTracer::dump_config() {
+  ESP_LOGCONFIG(TAG, "GT911 Latency Tracer:");
+  ESP_LOGCONFIG(TAG, "  Percentile: %u", this->percentile_);
+  for (uint8_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+    LOG_SENSOR("  ", STAGE_NAMES[i], this->sensors_[i]);
+  }
+}
+
+}  // namespace gt911
+}  // namespace esphome
+
+#endif  // USE_GT911_LATENCY
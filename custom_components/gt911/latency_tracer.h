@@ -0,0 +1,80 @@
+#pragma once
+
+#include "esphome/core/automation.h"
+#include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+
+#ifdef USE_GT911_LATENCY
+
+#include "esphome/components/sensor/sensor.h"
+#include <functional>
+
+namespace esphome {
+namespace gt911 {
+
+/// Steps between a finger touching the glass and the panel showing it, in order
+enum LatencyStage : uint8_t {
+  LATENCY_STAGE_READ,
+  LATENCY_STAGE_DISPATCH,
+  LATENCY_STAGE_UPDATE_START,
+  LATENCY_STAGE_UPLOAD_DONE,
+  LATENCY_STAGE_LUT_DONE,
+  LATENCY_STAGE_COUNT,
+};
+
+/** Times touches from the GT911 interrupt through to the end of the display waveform.
+ *
+ * A trace starts when a touch is dispatched while no other trace is open and follows the next
+ * display update. The stages are kept relative to the interrupt for the last traces, the
+ * sensors publish a percentile of each.
+ */
+class LatencyTracer : public PollingComponent {
+ public:
+  void set_percentile(uint8_t percentile) { percentile_ = percentile; }
+  void set_stage_sensor(LatencyStage stage, sensor::Sensor *sensor) { sensors_[stage] = sensor; }
+  /** Callback for a display to report its frames with.
+   *
+   * The display passes its stages as 0 for the update start, 1 for the upload and 2 for the end of the
+   * waveform, so the tracer doesn't depend on any display driver.
+   */
+  std::function<void(uint8_t, uint32_t)> display_stage_callback();
+
+  /// Touch side of a trace, called by the touchscreen when it dispatches a report
+  void touch(uint32_t interrupt_us, uint32_t read_us, uint32_t dispatch_us);
+  /// Display side of a trace, the LUT stage closes it
+  void mark(LatencyStage stage, uint32_t time_us);
+
+  /// Latency of a stage in ms at the given percentile, NAN without traces
+  float percentile(LatencyStage stage, uint8_t percentile);
+  void log_latency();
+
+  void update() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  static const uint8_t HISTORY = 32;
+
+  uint8_t percentile_{90};
+  sensor::Sensor *sensors_[LATENCY_STAGE_COUNT]{};
+
+  // stage times of the open trace, 0 when the stage did not happen yet
+  bool open_{false};
+  uint32_t interrupt_us_{0};
+  uint32_t stages_us_[LATENCY_STAGE_COUNT]{};
+
+  // finished traces, in us after the interrupt
+  uint32_t history_[HISTORY][LATENCY_STAGE_COUNT]{};
+  uint8_t history_index_{0};
+  uint8_t history_count_{0};
+};
+
+template<typename... Ts> class LogLatencyAction : public Action<Ts...>, public Parented<LatencyTracer> {
+ public:
+  void play(Ts... x) override { this->parent_->log_latency(); }
+};
+
+}  // namespace gt911
+}  // namespace esphome
+
+#endif  // USE_GT911_LATENCY
@@ -0,0 +1,86 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome import automation
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_MILLISECOND,
+)
+from .touchscreen import gt911, GT911
+
+DEPENDENCIES = ["touchscreen"]
+
+CONF_GT911_ID = "gt911_id"
+CONF_DISPLAY_ID = "display_id"
+CONF_PERCENTILE = "percentile"
+CONF_READ = "read"
+CONF_DISPATCH = "dispatch"
+CONF_UPDATE_START = "update_start"
+CONF_UPLOAD_DONE = "upload_done"
+CONF_LUT_DONE = "lut_done"
+
+LatencyTracer = gt911.class_("LatencyTracer", cg.PollingComponent)
+LogLatencyAction = gt911.class_("LogLatencyAction", automation.Action)
+LatencyStage = gt911.enum("LatencyStage")
+# declared here so the display component does not have to be imported
+IT8951ESensor = cg.esphome_ns.namespace("it8951e").class_("IT8951ESensor")
+
+STAGES = {
+    CONF_READ: LatencyStage.LATENCY_STAGE_READ,
+    CONF_DISPATCH: LatencyStage.LATENCY_STAGE_DISPATCH,
+    CONF_UPDATE_START: LatencyStage.LATENCY_STAGE_UPDATE_START,
+    CONF_UPLOAD_DONE: LatencyStage.LATENCY_STAGE_UPLOAD_DONE,
+    CONF_LUT_DONE: LatencyStage.LATENCY_STAGE_LUT_DONE,
+}
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(LatencyTracer),
+        cv.GenerateID(CONF_GT911_ID): cv.use_id(GT911),
+        cv.Optional(CONF_DISPLAY_ID): cv.use_id(IT8951ESensor),
+        cv.Optional(CONF_PERCENTILE, default=90): cv.int_range(min=1, max=100),
+        **{
+            cv.Optional(key): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MILLISECOND,
+                accuracy_decimals=1,
+                state_class=STATE_CLASS_MEASUREMENT,
+            )
+            for key in STAGES
+        },
+    }
+).extend(cv.polling_component_schema("60s"))
+
+
+@automation.register_action(
+    "gt911.log_latency",
+    LogLatencyAction,
+    automation.maybe_simple_id(
+        {
+            cv.GenerateID(): cv.use_id(LatencyTracer),
+        }
+    ),
+)
+async def gt911_log_latency_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+
+async def to_code(config):
+    cg.add_define("USE_GT911_LATENCY")
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+    cg.add(var.set_percentile(config[CONF_PERCENTILE]))
+
+    touchscreen = await cg.get_variable(config[CONF_GT911_ID])
+    cg.add(touchscreen.set_latency_tracer(var))
+    if CONF_DISPLAY_ID in config:
+        # the display reports its frame stages through a plain callback, the tracer doesn't know the driver
+        display = await cg.get_variable(config[CONF_DISPLAY_ID])
+        cg.add(display.add_on_stage_callback(var.display_stage_callback()))
+
+    for key, stage in STAGES.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(var.set_stage_sensor(stage, sens))
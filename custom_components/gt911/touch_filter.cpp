@@ -0,0 +1,76 @@
+#include "touch_filter.h"
+#include "esphome/core/helpers.h"
+
+#include <cmath>
+
+namespace esphome {
+namespace gt911 {
+
+float TouchFilter::alpha_(float cutoff, float dt) {
+  float tau = 1.0f / (2.0f * float(M_PI) * cutoff);
+  return 1.0f / (1.0f + tau / dt);
+}
+
+void TouchFilter::reset() {
+  for (auto &track : this->tracks_) {
+    track.active = false;
+  }
+}
+
+void TouchFilter::apply(touchscreen::TouchPoint *points, uint8_t count, uint32_t now) {
+  bool seen[GESTURE_MAX_TOUCHES] = {false};
+
+  for (uint8_t i = 0; i < count; i++) {
+    touchscreen::TouchPoint &point = points[i];
+    int index = -1, free_index = -1;
+    for (int t = 0; t < GESTURE_MAX_TOUCHES; t++) {
+      if (this->tracks_[t].active && this->tracks_[t].id == point.id) {
+        index = t;
+        break;
+      }
+      if (!this->tracks_[t].active && free_index < 0)
+        free_index = t;
+    }
+
+    if (index < 0) {
+      if (free_index < 0)
+        continue;
+      // a new finger starts out at its raw position, at rest
+      TrackFilter &track = this->tracks_[free_index];
+      track = TrackFilter{point.id, true, now, float(point.x), float(point.y), 0.0f, 0.0f};
+      seen[free_index] = true;
+      continue;
+    }
+
+    TrackFilter &track = this->tracks_[index];
+    seen[index] = true;
+    uint32_t elapsed = now - track.last_ms;
+    if (elapsed == 0) {
+      elapsed = 1;
+    }
+    float dt = elapsed / 1000.0f;
+    track.last_ms = now;
+
+    // velocity first, its magnitude sets the cutoff of the position
+    float alpha_d = alpha_(this->derivative_cutoff_, dt);
+    track.dx += alpha_d * ((point.x - track.x) / dt - track.dx);
+    track.dy += alpha_d * ((point.y - track.y) / dt - track.dy);
+
+    float speed = sqrtf(track.dx * track.dx + track.dy * track.dy);
+    float alpha = alpha_(this->min_cutoff_ + this->beta_ * speed, dt);
+    track.x += alpha * (point.x - track.x);
+    track.y += alpha * (point.y - track.y);
+
+    float ahead = this->prediction_ / 1000.0f;
+    point.x = clamp<float>(roundf(track.x + track.dx * ahead), 0.0f, this->max_x_);
+    point.y = clamp<float>(roundf(track.y + track.dy * ahead), 0.0f, this->max_y_);
+  }
+
+  for (int t = 0; t < GESTURE_MAX_TOUCHES; t++) {
+    if (!seen[t])
+      this->tracks_[t].active = false;
+  }
+}
+
+}  // namespace gt911
+}  // namespace esphome
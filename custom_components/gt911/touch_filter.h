@@ -0,0 +1,57 @@
+#pragma once
+
+#include "esphome/components/touchscreen/touchscreen.h"
+#include "gesture.h"
+
+namespace esphome {
+namespace gt911 {
+
+/// Filter state of one finger
+struct TrackFilter {
+  uint8_t id;
+  bool active;
+  uint32_t last_ms;
+  float x;
+  float y;
+  // filtered velocity in pixels per second
+  float dx;
+  float dy;
+};
+
+/** 1-Euro filter for every tracked finger, with optional prediction.
+ *
+ * Slow movements are smoothed hard to remove jitter, the cutoff rises with
+ * the speed of the finger so fast strokes don't lag behind. The filtered
+ * velocity extrapolates the position prediction ms ahead, to make up for
+ * the I2C and e-paper latency.
+ */
+class TouchFilter {
+ public:
+  void set_min_cutoff(float min_cutoff) { min_cutoff_ = min_cutoff; }
+  void set_beta(float beta) { beta_ = beta; }
+  void set_derivative_cutoff(float derivative_cutoff) { derivative_cutoff_ = derivative_cutoff; }
+  void set_prediction(uint32_t prediction) { prediction_ = prediction; }
+  void set_max(uint16_t max_x, uint16_t max_y) {
+    max_x_ = max_x;
+    max_y_ = max_y;
+  }
+
+  /// Filter the points of one report in place, fingers missing from it are forgotten.
+  void apply(touchscreen::TouchPoint *points, uint8_t count, uint32_t now);
+  void reset();
+
+ protected:
+  static float alpha_(float cutoff, float dt);
+
+  TrackFilter tracks_[GESTURE_MAX_TOUCHES]{};
+
+  float min_cutoff_{1.0f};
+  float beta_{0.02f};
+  float derivative_cutoff_{1.0f};
+  uint32_t prediction_{0};
+  uint16_t max_x_{UINT16_MAX};
+  uint16_t max_y_{UINT16_MAX};
+};
+
+}  // namespace gt911
+}  // namespace esphome
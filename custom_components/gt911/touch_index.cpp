@@ -0,0 +1,102 @@
+#include "touch_index.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+
+namespace esphome {
+namespace gt911 {
+
+// edge of a grid cell in pixels, about the size of a small button
+static const uint16_t TOUCH_INDEX_CELL = 32;
+
+void TouchIndex::add(touchscreen::TouchListener *listener, int16_t x_min, int16_t x_max, int16_t y_min,
+                     int16_t y_max) {
+  this->listeners_.push_back(IndexedListener{listener, x_min, x_max, y_min, y_max, false});
+}
+
+bool TouchIndex::contains(touchscreen::TouchListener *listener) const {
+  return std::any_of(this->listeners_.begin(), this->listeners_.end(),
+                     [listener](const IndexedListener &indexed) { return indexed.listener == listener; });
+}
+
+uint16_t TouchIndex::cell_column_(int16_t x) const {
+  return clamp<int>(x / TOUCH_INDEX_CELL, 0, this->columns_ - 1);
+}
+
+uint16_t TouchIndex::cell_row_(int16_t y) const { return clamp<int>(y / TOUCH_INDEX_CELL, 0, this->rows_ - 1); }
+
+void TouchIndex::build(uint16_t width, uint16_t height) {
+  this->columns_ = std::max<uint16_t>((width + TOUCH_INDEX_CELL - 1) / TOUCH_INDEX_CELL, 1);
+  this->rows_ = std::max<uint16_t>((height + TOUCH_INDEX_CELL - 1) / TOUCH_INDEX_CELL, 1);
+  uint32_t cells = this->columns_ * this->rows_;
+
+  // count the rectangles per cell first, then fill them in, so the lists are one flat array
+  std::vector<uint16_t> counts(cells, 0);
+  for (auto &indexed : this->listeners_) {
+    for (uint16_t row = this->cell_row_(indexed.y_min); row <= this->cell_row_(indexed.y_max); row++) {
+      for (uint16_t column = this->cell_column_(indexed.x_min); column <= this->cell_column_(indexed.x_max);
+           column++) {
+        counts[row * this->columns_ + column]++;
+      }
+    }
+  }
+
+  this->cell_start_.assign(cells + 1, 0);
+  for (uint32_t i = 0; i < cells; i++) {
+    this->cell_start_[i + 1] = this->cell_start_[i] + counts[i];
+  }
+  this->cell_items_.resize(this->cell_start_[cells]);
+
+  std::fill(counts.begin(), counts.end(), 0);
+  for (uint16_t index = 0; index < this->listeners_.size(); index++) {
+    const auto &indexed = this->listeners_[index];
+    for (uint16_t row = this->cell_row_(indexed.y_min); row <= this->cell_row_(indexed.y_max); row++) {
+      for (uint16_t column = this->cell_column_(indexed.x_min); column <= this->cell_column_(indexed.x_max);
+           column++) {
+        uint32_t cell = row * this->columns_ + column;
+        this->cell_items_[this->cell_start_[cell] + counts[cell]++] = index;
+      }
+    }
+  }
+}
+
+void TouchIndex::touch(const touchscreen::TouchPoint *points, uint8_t count) {
+  if (this->cell_start_.empty()) {
+    return;
+  }
+
+  this->next_active_.clear();
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t cell = this->cell_row_(points[i].y) * this->columns_ + this->cell_column_(points[i].x);
+    for (uint16_t item = this->cell_start_[cell]; item < this->cell_start_[cell + 1]; item++) {
+      uint16_t index = this->cell_items_[item];
+      IndexedListener &indexed = this->listeners_[index];
+      // the listener checks its own bounds and page, a point beside it releases it
+      indexed.listener->touch(points[i]);
+      if (!indexed.hit) {
+        indexed.hit = true;
+        this->next_active_.push_back(index);
+      }
+    }
+  }
+
+  for (uint16_t index : this->active_) {
+    if (!this->listeners_[index].hit) {
+      this->listeners_[index].listener->release();
+    }
+  }
+  for (uint16_t index : this->next_active_) {
+    this->listeners_[index].hit = false;
+  }
+  std::swap(this->active_, this->next_active_);
+}
+
+void TouchIndex::release() {
+  for (uint16_t index : this->active_) {
+    this->listeners_[index].listener->release();
+  }
+  this->active_.clear();
+}
+
+}  // namespace gt911
+}  // namespace esphome
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "esphome/components/touchscreen/touchscreen.h"
+
+namespace esphome {
+namespace gt911 {
+
+/// A listener that only cares about touches inside its rectangle
+struct IndexedListener {
+  touchscreen::TouchListener *listener;
+  int16_t x_min;
+  int16_t x_max;
+  int16_t y_min;
+  int16_t y_max;
+  // got a point in the report being dispatched
+  bool hit;
+};
+
+/** Uniform grid over the touch area, every cell lists the rectangles overlapping it.
+ *
+ * A point is only handed to the listeners of its cell, and a listener is released on its own once
+ * no point lands in its cell anymore. The cost per touch depends on how many rectangles share a
+ * cell, not on how many there are.
+ */
+class TouchIndex {
+ public:
+  void add(touchscreen::TouchListener *listener, int16_t x_min, int16_t x_max, int16_t y_min, int16_t y_max);
+  bool contains(touchscreen::TouchListener *listener) const;
+  size_t size() const { return this->listeners_.size(); }
+
+  /// Sort the rectangles into cells, width and height in touch coordinates
+  void build(uint16_t width, uint16_t height);
+  void touch(const touchscreen::TouchPoint *points, uint8_t count);
+  void release();
+
+ protected:
+  uint16_t cell_column_(int16_t x) const;
+  uint16_t cell_row_(int16_t y) const;
+
+  std::vector<IndexedListener> listeners_;
+  // listeners of cell i are cell_items_[cell_start_[i] .. cell_start_[i + 1]]
+  std::vector<uint16_t> cell_start_;
+  std::vector<uint16_t> cell_items_;
+  uint16_t columns_{0};
+  uint16_t rows_{0};
+  // listeners touched by the previous and the current report, so releases don't scan them all
+  std::vector<uint16_t> active_;
+  std::vector<uint16_t> next_active_;
+};
+
+}  // namespace gt911
+}  // namespace esphome
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "esphome/components/touchscreen/touchscreen.h"
+#include "gesture.h"
+
+namespace esphome {
+namespace gt911 {
+
+/// One touch report, the points and when the controller raised its interrupt
+struct TouchSample {
+  uint32_t time_ms;
+  // micros() of the interrupt and of the end of the I2C read, for the latency tracer
+  uint32_t interrupt_us;
+  uint32_t read_us;
+  uint8_t count;
+  touchscreen::TouchPoint points[GESTURE_MAX_TOUCHES];
+};
+
+/** Fixed size lock-free ring between one producer and one consumer.
+ *
+ * push() may run in an interrupt handler while pop() runs in the loop, the
+ * producer only writes head_ and the consumer only writes tail_. Holds at
+ * most N - 1 items, push() fails instead of overwriting.
+ */
+template<typename T, uint8_t N> class TouchRing {
+ public:
+  // always inlined, so a push from an IRAM_ATTR interrupt handler stays in IRAM with it
+  inline __attribute__((always_inline)) bool push(const T &item) {
+    uint8_t head = this->head_.load(std::memory_order_relaxed);
+    uint8_t next = (head + 1) % N;
+    if (next == this->tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    this->items_[head] = item;
+    this->head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item) {
+    uint8_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = this->items_[tail];
+    this->tail_.store((tail + 1) % N, std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  T items_[N];
+  std::atomic<uint8_t> head_{0};
+  std::atomic<uint8_t> tail_{0};
+};
+
+}  // namespace gt911
+}  // namespace esphome
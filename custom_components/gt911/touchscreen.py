@@ -2,25 +2,151 @@ import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome.components import i2c, sensor, touchscreen
 from esphome.const import (
-    CONF_ID
+    CONF_ID,
+    CONF_PLATFORM,
+    CONF_TRIGGER_ID,
 )
-from esphome import pins
+from esphome.core import CORE
+from esphome import automation, pins
 
 DEPENDENCIES = ['i2c']
 
 CONF_I2C_ADDR = 0x5D
 CONF_INTERRUPT_PIN = "interrupt_pin"
+CONF_TAP_DISTANCE = "tap_distance"
+CONF_LONG_PRESS_TIME = "long_press_time"
+CONF_SWIPE_DISTANCE = "swipe_distance"
+CONF_SWIPE_TIME = "swipe_time"
+CONF_ON_TAP = "on_tap"
+CONF_ON_LONG_PRESS = "on_long_press"
+CONF_ON_PINCH = "on_pinch"
+CONF_FILTER = "filter"
+CONF_MIN_CUTOFF = "min_cutoff"
+CONF_BETA = "beta"
+CONF_DERIVATIVE_CUTOFF = "derivative_cutoff"
+CONF_PREDICTION = "prediction"
+CONF_CONFIG = "config"
+CONF_REPORT_RATE = "report_rate"
+CONF_TOUCH_NUMBER = "touch_number"
+CONF_TOUCH_THRESHOLD = "touch_threshold"
+CONF_RELEASE_THRESHOLD = "release_threshold"
+CONF_MOVE_THRESHOLD = "move_threshold"
+CONF_GESTURE_REPORT_RATE = "gesture_report_rate"
+CONF_ON_WAKE_GESTURE = "on_wake_gesture"
+CONF_TOUCHSCREEN_ID = "touchscreen_id"
+CONF_X_MIN = "x_min"
+CONF_X_MAX = "x_max"
+CONF_Y_MIN = "y_min"
+CONF_Y_MAX = "y_max"
 
 gt911 = cg.esphome_ns.namespace('gt911')
 GT911 = gt911.class_('GT911', touchscreen.Touchscreen, cg.Component, i2c.I2CDevice)
+SwipeDirection = gt911.enum("SwipeDirection")
+
+TapTrigger = gt911.class_("TapTrigger", automation.Trigger.template(cg.int_, cg.int_))
+LongPressTrigger = gt911.class_("LongPressTrigger", automation.Trigger.template(cg.int_, cg.int_))
+SwipeTrigger = gt911.class_("SwipeTrigger", automation.Trigger.template(cg.float_))
+PinchTrigger = gt911.class_("PinchTrigger", automation.Trigger.template(cg.float_))
+SetReportRateAction = gt911.class_("SetReportRateAction", automation.Action)
+EnterLowPowerAction = gt911.class_("EnterLowPowerAction", automation.Action)
+WakeGestureTrigger = gt911.class_("WakeGestureTrigger", automation.Trigger.template(cg.uint8))
+
+FILTER_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MIN_CUTOFF, default=1.0): cv.positive_float,
+        cv.Optional(CONF_BETA, default=0.02): cv.positive_float,
+        cv.Optional(CONF_DERIVATIVE_CUTOFF, default=1.0): cv.positive_float,
+        cv.Optional(CONF_PREDICTION, default="0ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=200)),
+        ),
+    }
+)
+
+# the controller reports every 5 to 20 ms
+validate_report_rate = cv.All(cv.frequency, cv.Range(min=50, max=200))
+
+# settings left out keep the value stored in the controller
+CONTROLLER_CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_REPORT_RATE): validate_report_rate,
+        cv.Optional(CONF_TOUCH_NUMBER): cv.int_range(min=1, max=5),
+        cv.Optional(CONF_TOUCH_THRESHOLD): cv.uint8_t,
+        cv.Optional(CONF_RELEASE_THRESHOLD): cv.uint8_t,
+        cv.Optional(CONF_MOVE_THRESHOLD): cv.uint8_t,
+        cv.Optional(CONF_GESTURE_REPORT_RATE): validate_report_rate,
+    }
+)
+
+SWIPE_TRIGGERS = {
+    "on_swipe_left": SwipeDirection.SWIPE_LEFT,
+    "on_swipe_right": SwipeDirection.SWIPE_RIGHT,
+    "on_swipe_up": SwipeDirection.SWIPE_UP,
+    "on_swipe_down": SwipeDirection.SWIPE_DOWN,
+}
 
 CONFIG_SCHEMA = touchscreen.TOUCHSCREEN_SCHEMA.extend({
     cv.GenerateID(): cv.declare_id(GT911),
     cv.Required(CONF_INTERRUPT_PIN): cv.All(
                 pins.internal_gpio_input_pin_schema
             ),
+    cv.Optional(CONF_TAP_DISTANCE, default=20): cv.uint16_t,
+    cv.Optional(CONF_LONG_PRESS_TIME, default="500ms"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_SWIPE_DISTANCE, default=80): cv.uint16_t,
+    cv.Optional(CONF_SWIPE_TIME, default="1s"): cv.positive_time_period_milliseconds,
+    cv.Optional(CONF_FILTER): FILTER_SCHEMA,
+    cv.Optional(CONF_CONFIG): CONTROLLER_CONFIG_SCHEMA,
+    cv.Optional(CONF_ON_TAP): automation.validate_automation(
+        {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(TapTrigger)}
+    ),
+    cv.Optional(CONF_ON_LONG_PRESS): automation.validate_automation(
+        {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(LongPressTrigger)}
+    ),
+    cv.Optional(CONF_ON_PINCH): automation.validate_automation(
+        {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(PinchTrigger)}
+    ),
+    cv.Optional(CONF_ON_WAKE_GESTURE): automation.validate_automation(
+        {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(WakeGestureTrigger)}
+    ),
+    **{
+        cv.Optional(key): automation.validate_automation(
+            {cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SwipeTrigger)}
+        )
+        for key in SWIPE_TRIGGERS
+    },
 }).extend(cv.COMPONENT_SCHEMA).extend(i2c.i2c_device_schema(CONF_I2C_ADDR))
 
+@automation.register_action(
+    "gt911.set_report_rate",
+    SetReportRateAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(GT911),
+            cv.Required(CONF_REPORT_RATE): cv.templatable(validate_report_rate),
+        }
+    ),
+)
+async def gt911_set_report_rate_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_REPORT_RATE], args, cg.float_)
+    cg.add(var.set_report_rate(template_))
+    return var
+
+@automation.register_action(
+    "gt911.enter_low_power",
+    EnterLowPowerAction,
+    automation.maybe_simple_id(
+        {
+            cv.GenerateID(): cv.use_id(GT911),
+        }
+    ),
+)
+async def gt911_enter_low_power_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
@@ -30,4 +156,63 @@ async def to_code(config):
     interrupt_pin = await cg.gpio_pin_expression(config[CONF_INTERRUPT_PIN])
     cg.add(var.set_interrupt_pin(interrupt_pin))
 
+    gestures = var.get_gestures()
+    cg.add(gestures.set_tap_distance(config[CONF_TAP_DISTANCE]))
+    cg.add(gestures.set_long_press_time(config[CONF_LONG_PRESS_TIME]))
+    cg.add(gestures.set_swipe_distance(config[CONF_SWIPE_DISTANCE]))
+    cg.add(gestures.set_swipe_time(config[CONF_SWIPE_TIME]))
+
+    if CONF_CONFIG in config:
+        conf = config[CONF_CONFIG]
+        if CONF_REPORT_RATE in conf:
+            cg.add(var.set_report_rate(conf[CONF_REPORT_RATE]))
+        if CONF_TOUCH_NUMBER in conf:
+            cg.add(var.set_touch_number(conf[CONF_TOUCH_NUMBER]))
+        if CONF_TOUCH_THRESHOLD in conf:
+            cg.add(var.set_touch_threshold(conf[CONF_TOUCH_THRESHOLD]))
+        if CONF_RELEASE_THRESHOLD in conf:
+            cg.add(var.set_release_threshold(conf[CONF_RELEASE_THRESHOLD]))
+        if CONF_MOVE_THRESHOLD in conf:
+            cg.add(var.set_move_threshold(conf[CONF_MOVE_THRESHOLD]))
+        if CONF_GESTURE_REPORT_RATE in conf:
+            cg.add(var.set_gesture_report_rate(conf[CONF_GESTURE_REPORT_RATE]))
+
+    # touchscreen binary sensors on this touchscreen are hit tested through the grid index
+    for conf in CORE.config.get("binary_sensor", []):
+        if conf.get(CONF_PLATFORM) != "touchscreen":
+            continue
+        if conf[CONF_TOUCHSCREEN_ID].id != config[CONF_ID].id:
+            continue
+        listener = await cg.get_variable(conf[CONF_ID])
+        cg.add(
+            var.add_indexed_listener(
+                listener, conf[CONF_X_MIN], conf[CONF_X_MAX], conf[CONF_Y_MIN], conf[CONF_Y_MAX]
+            )
+        )
+
+    if CONF_FILTER in config:
+        conf = config[CONF_FILTER]
+        touch_filter = var.enable_filter()
+        cg.add(touch_filter.set_min_cutoff(conf[CONF_MIN_CUTOFF]))
+        cg.add(touch_filter.set_beta(conf[CONF_BETA]))
+        cg.add(touch_filter.set_derivative_cutoff(conf[CONF_DERIVATIVE_CUTOFF]))
+        cg.add(touch_filter.set_prediction(conf[CONF_PREDICTION]))
+
+    for conf in config.get(CONF_ON_TAP, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(int, "x"), (int, "y")], conf)
+    for conf in config.get(CONF_ON_LONG_PRESS, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(int, "x"), (int, "y")], conf)
+    for conf in config.get(CONF_ON_PINCH, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(float, "scale")], conf)
+    for conf in config.get(CONF_ON_WAKE_GESTURE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.uint8, "gesture")], conf)
+    for key, direction in SWIPE_TRIGGERS.items():
+        for conf in config.get(key, []):
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var, direction)
+            await automation.build_automation(trigger, [(float, "velocity")], conf)
+
     
\ No newline at end of file
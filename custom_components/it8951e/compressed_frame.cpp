@@ -0,0 +1,149 @@
+#include "compressed_frame.h"
+#include "esphome/core/helpers.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace esphome {
+namespace it8951e {
+
+static const uint16_t MAX_TOKEN_LENGTH = 0x4000;
+static const uint8_t MIN_RUN_LENGTH = 3;
+
+CompressedFrame::CompressedFrame(CompressedFrame &&other) noexcept { *this = std::move(other); }
+
+CompressedFrame &CompressedFrame::operator=(CompressedFrame &&other) noexcept {
+  if (this != &other) {
+    this->release();
+    this->data_ = other.data_;
+    this->size_ = other.size_;
+    this->raw_size_ = other.raw_size_;
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.raw_size_ = 0;
+  }
+  return *this;
+}
+
+void CompressedFrame::release() {
+  if (this->data_ != nullptr) {
+    ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+    allocator.deallocate(this->data_, this->size_);
+  }
+  this->data_ = nullptr;
+  this->size_ = 0;
+  this->raw_size_ = 0;
+}
+
+bool CompressedFrame::store(const uint8_t *frame, uint32_t length) {
+  this->release();
+
+  // first pass only sizes the stream so it can be allocated exactly
+  uint32_t size = encode_(frame, length, nullptr);
+
+  ExternalRAMAllocator<uint8_t> allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint8_t *data = allocator.allocate(size);
+  if (data == nullptr) {
+    return false;
+  }
+
+  encode_(frame, length, data);
+  this->data_ = data;
+  this->size_ = size;
+  this->raw_size_ = length;
+  return true;
+}
+
+static uint32_t emit_header(uint8_t *out, uint32_t pos, bool run, uint16_t length) {
+  uint16_t value = length - 1;
+  uint8_t control = run ? 0x80 : 0x00;
+  if (value > 0x3F) {
+    if (out != nullptr) {
+      out[pos] = control | 0x40 | (value >> 8);
+      out[pos + 1] = value & 0xFF;
+    }
+    return pos + 2;
+  }
+  if (out != nullptr) {
+    out[pos] = control | value;
+  }
+  return pos + 1;
+}
+
+uint32_t CompressedFrame::encode_(const uint8_t *frame, uint32_t length, uint8_t *out) {
+  uint32_t pos = 0;
+  uint32_t i = 0;
+  uint32_t literal_start = 0;
+
+  auto flush_literal = [&](uint32_t end) {
+    while (literal_start < end) {
+      uint16_t count = std::min<uint32_t>(end - literal_start, MAX_TOKEN_LENGTH);
+      pos = emit_header(out, pos, false, count);
+      if (out != nullptr) {
+        memcpy(out + pos, frame + literal_start, count);
+      }
+      pos += count;
+      literal_start += count;
+    }
+  };
+
+  while (i < length) {
+    uint32_t run = 1;
+    while (i + run < length && run < MAX_TOKEN_LENGTH && frame[i + run] == frame[i]) {
+      run++;
+    }
+
+    if (run < MIN_RUN_LENGTH) {
+      i += run;
+      continue;
+    }
+
+    flush_literal(i);
+    pos = emit_header(out, pos, true, run);
+    if (out != nullptr) {
+      out[pos] = frame[i];
+    }
+    pos++;
+    i += run;
+    literal_start = i;
+  }
+  flush_literal(length);
+
+  return pos;
+}
+
+size_t RLEDecoder::read(uint8_t *out, size_t length) {
+  size_t done = 0;
+  while (done < length) {
+    if (this->remaining_ == 0) {
+      if (this->pos_ >= this->size_) {
+        break;
+      }
+      uint8_t control = this->data_[this->pos_++];
+      uint16_t value = control & 0x3F;
+      if (control & 0x40) {
+        value = (value << 8) | this->data_[this->pos_++];
+      }
+      this->remaining_ = value + 1;
+      this->is_run_ = control & 0x80;
+      if (this->is_run_) {
+        this->run_value_ = this->data_[this->pos_++];
+      }
+    }
+
+    uint16_t count = std::min<size_t>(this->remaining_, length - done);
+    if (this->is_run_) {
+      memset(out + done, this->run_value_, count);
+    } else {
+      memcpy(out + done, this->data_ + this->pos_, count);
+      this->pos_ += count;
+    }
+    this->remaining_ -= count;
+    done += count;
+  }
+  return done;
+}
+
+}  // namespace it8951e
+}  // namespace esphome
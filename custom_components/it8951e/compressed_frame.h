@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace it8951e {
+
+/** A 4bpp frame run-length compressed into external RAM.
+ *
+ * E-paper UIs are mostly flat white, so frames are stored as a stream of
+ * runs and literals. Every token starts with a control byte:
+ *
+ *   bit 7    1 = run of the following byte, 0 = literal bytes follow
+ *   bit 6    1 = the length continues in the next byte (14 bit length)
+ *   bit 5-0  length - 1, high bits when bit 6 is set
+ *
+ * Frames are decoded as a stream with a RLEDecoder so they can be written
+ * out a row at a time without ever holding the raw frame.
+ */
+class CompressedFrame {
+ public:
+  CompressedFrame() = default;
+  CompressedFrame(const CompressedFrame &) = delete;
+  CompressedFrame &operator=(const CompressedFrame &) = delete;
+  CompressedFrame(CompressedFrame &&other) noexcept;
+  CompressedFrame &operator=(CompressedFrame &&other) noexcept;
+  ~CompressedFrame() { this->release(); }
+
+  /// Compress length bytes of frame, replacing any stored frame. False if out of memory.
+  bool store(const uint8_t *frame, uint32_t length);
+  void release();
+
+  bool is_valid() const { return this->data_ != nullptr; }
+  uint32_t size() const { return this->size_; }
+  uint32_t raw_size() const { return this->raw_size_; }
+  const uint8_t *data() const { return this->data_; }
+
+ protected:
+  static uint32_t encode_(const uint8_t *frame, uint32_t length, uint8_t *out);
+
+  uint8_t *data_{nullptr};
+  uint32_t size_{0};
+  uint32_t raw_size_{0};
+};
+
+/// Streaming decoder for a CompressedFrame.
+class RLEDecoder {
+ public:
+  explicit RLEDecoder(const CompressedFrame &frame) : data_(frame.data()), size_(frame.size()) {}
+
+  /// Decode the next length bytes into out. Returns the number of bytes decoded.
+  size_t read(uint8_t *out, size_t length);
+
+ protected:
+  const uint8_t *data_;
+  uint32_t size_;
+  uint32_t pos_{0};
+  uint16_t remaining_{0};
+  bool is_run_{false};
+  uint8_t run_value_{0};
+};
+
+}  // namespace it8951e
+}  // namespace esphome
@@ -2,26 +2,68 @@ import esphome.codegen as cg
 from esphome import pins
 from esphome import automation
 import esphome.config_validation as cv
-from esphome.components import display, spi
+from esphome.core import CORE, HexInt
+from esphome.components import display, spi, touchscreen
 from esphome.const import (
     CONF_NAME,
+    CONF_MODE,
+    CONF_PAGE_ID,
+    CONF_PLATFORM,
     CONF_ID,
     CONF_RESET_PIN,
     CONF_BUSY_PIN,
     CONF_PAGES,
     CONF_LAMBDA,
     CONF_REVERSED,
+    CONF_FILE,
+    CONF_RAW_DATA_ID,
 )
 
 DEPENDENCIES = ['spi']
 
 CONF_DISPLAY_CS_PIN = "display_cs_pin"
+CONF_MIN_UPDATE_INTERVAL = "min_update_interval"
+CONF_TOUCH_FEEDBACK = "touch_feedback"
+CONF_PAGE_CACHE = "page_cache"
+CONF_SLOT = "slot"
+CONF_GAMMA = "gamma"
+CONF_COLOR_ON_IS_INK = "color_on_is_ink"
+CONF_IMAGE_DECODER = "image_decoder"
+CONF_RENDER_TASK = "render_task"
+CONF_DATA_RATE = "data_rate"
+CONF_CALIBRATE_DATA_RATE = "calibrate_data_rate"
+CONF_MAX_DATA_RATE = "max_data_rate"
+CONF_TOUCHSCREEN_ID = "touchscreen_id"
+CONF_X = "x"
+CONF_Y = "y"
+CONF_X_MIN = "x_min"
+CONF_X_MAX = "x_max"
+CONF_Y_MIN = "y_min"
+CONF_Y_MAX = "y_max"
 
 it8951e_ns = cg.esphome_ns.namespace('it8951e')
 IT8951ESensor = it8951e_ns.class_(
     'IT8951ESensor', cg.PollingComponent, spi.SPIDevice, display.DisplayBuffer
 )
 ClearAction = it8951e_ns.class_("ClearAction", automation.Action)
+UpdateNowAction = it8951e_ns.class_("UpdateNowAction", automation.Action)
+SaveScreenAction = it8951e_ns.class_("SaveScreenAction", automation.Action)
+RestoreScreenAction = it8951e_ns.class_("RestoreScreenAction", automation.Action)
+DrawImageAction = it8951e_ns.class_("DrawImageAction", automation.Action)
+TouchFeedbackListener = it8951e_ns.class_("TouchFeedbackListener", touchscreen.TouchListener)
+
+FEEDBACK_MODES = {
+    "DU": 1,
+    "A2": 7,
+}
+
+TOUCH_FEEDBACK_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(TouchFeedbackListener),
+        cv.Required(CONF_TOUCHSCREEN_ID): cv.use_id(touchscreen.Touchscreen),
+        cv.Optional(CONF_MODE, default="DU"): cv.enum(FEEDBACK_MODES, upper=True),
+    }
+)
 
 CONFIG_SCHEMA = cv.All(
     display.FULL_DISPLAY_SCHEMA.extend(
@@ -32,6 +74,16 @@ CONFIG_SCHEMA = cv.All(
             cv.Required(CONF_BUSY_PIN): pins.gpio_input_pin_schema,
             cv.Required(CONF_DISPLAY_CS_PIN): pins.gpio_input_pin_schema,
             cv.Optional(CONF_REVERSED): cv.boolean,
+            cv.Optional(CONF_MIN_UPDATE_INTERVAL, default="0ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_TOUCH_FEEDBACK): TOUCH_FEEDBACK_SCHEMA,
+            cv.Optional(CONF_PAGE_CACHE, default=False): cv.boolean,
+            cv.Optional(CONF_GAMMA, default=1.0): cv.positive_float,
+            cv.Optional(CONF_COLOR_ON_IS_INK, default=False): cv.boolean,
+            cv.Optional(CONF_IMAGE_DECODER, default=False): cv.boolean,
+            cv.Optional(CONF_RENDER_TASK, default=False): cv.All(cv.boolean, cv.only_on_esp32),
+            cv.Optional(CONF_DATA_RATE): cv.All(cv.frequency, cv.Range(min=1e6, max=80e6)),
+            cv.Optional(CONF_CALIBRATE_DATA_RATE, default=False): cv.templatable(cv.boolean),
+            cv.Optional(CONF_MAX_DATA_RATE, default="40MHz"): cv.All(cv.frequency, cv.Range(min=1e6, max=80e6)),
         }
     )
     .extend(cv.polling_component_schema("1s"))
@@ -39,6 +91,15 @@ CONFIG_SCHEMA = cv.All(
     cv.has_at_most_one_key(CONF_PAGES, CONF_LAMBDA),
 )
 
+@automation.register_action(
+    "IT8951E.update_now",
+    UpdateNowAction,
+    automation.maybe_simple_id(
+        {
+            cv.GenerateID(): cv.use_id(IT8951ESensor),
+        }
+    ),
+)
 @automation.register_action(
     "IT8951E.clear",
     ClearAction,
@@ -53,6 +114,59 @@ async def bm8563_read_time_to_code(config, action_id, template_arg, args):
     await cg.register_parented(var, config[CONF_ID])
     return var
 
+SCREEN_ACTION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(IT8951ESensor),
+        cv.Required(CONF_SLOT): cv.templatable(cv.uint8_t),
+    }
+)
+
+
+@automation.register_action("IT8951E.save_screen", SaveScreenAction, SCREEN_ACTION_SCHEMA)
+@automation.register_action("IT8951E.restore_screen", RestoreScreenAction, SCREEN_ACTION_SCHEMA)
+async def it8951e_screen_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    template_ = await cg.templatable(config[CONF_SLOT], args, cg.uint8)
+    cg.add(var.set_slot(template_))
+    return var
+
+@automation.register_action(
+    "IT8951E.draw_image",
+    DrawImageAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(IT8951ESensor),
+            cv.Required(CONF_FILE): cv.file_,
+            cv.Optional(CONF_X, default=0): cv.templatable(cv.int_),
+            cv.Optional(CONF_Y, default=0): cv.templatable(cv.int_),
+            cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
+        }
+    ),
+)
+async def it8951e_draw_image_to_code(config, action_id, template_arg, args):
+    # the JPEG or PNG file is embedded as is, it is decoded straight into the controller when the action runs
+    with open(CORE.relative_config_path(config[CONF_FILE]), "rb") as f:
+        data = f.read()
+    prog_arr = cg.progmem_array(config[CONF_RAW_DATA_ID], [HexInt(x) for x in data])
+    enable_image_decoder()
+
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_data(prog_arr, len(data)))
+    template_ = await cg.templatable(config[CONF_X], args, cg.int_)
+    cg.add(var.set_x(template_))
+    template_ = await cg.templatable(config[CONF_Y], args, cg.int_)
+    cg.add(var.set_y(template_))
+    return var
+
+
+def enable_image_decoder():
+    cg.add_define("USE_IT8951E_IMAGE_DECODER")
+    cg.add_library("bitbank2/JPEGDEC", "1.2.8")
+    cg.add_library("bitbank2/PNGdec", "1.0.1")
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await display.register_display(var, config)
@@ -74,4 +188,45 @@ async def to_code(config):
         busy = await cg.gpio_pin_expression(config[CONF_BUSY_PIN])
         cg.add(var.set_busy_pin(busy))
     if CONF_REVERSED in config:
-        cg.add(var.set_reversed(config[CONF_REVERSED]))
\ No newline at end of file
+        cg.add(var.set_reversed(config[CONF_REVERSED]))
+    cg.add(var.set_min_update_interval(config[CONF_MIN_UPDATE_INTERVAL]))
+    cg.add(var.set_gamma(config[CONF_GAMMA]))
+    cg.add(var.set_color_on_is_ink(config[CONF_COLOR_ON_IS_INK]))
+    if CONF_DATA_RATE in config:
+        cg.add(var.set_data_rate(int(config[CONF_DATA_RATE])))
+    calibrate = await cg.templatable(config[CONF_CALIBRATE_DATA_RATE], [], cg.bool_)
+    cg.add(var.set_calibrate_data_rate(calibrate))
+    cg.add(var.set_max_data_rate(int(config[CONF_MAX_DATA_RATE])))
+    if config[CONF_IMAGE_DECODER]:
+        enable_image_decoder()
+    if config[CONF_RENDER_TASK]:
+        cg.add_define("USE_IT8951E_RENDER_TASK")
+        cg.add(var.set_render_task(True))
+    if config[CONF_PAGE_CACHE] and CONF_PAGES in config:
+        cg.add(var.set_page_cache_size(len(config[CONF_PAGES])))
+    if CONF_TOUCH_FEEDBACK in config:
+        await setup_touch_feedback(var, config[CONF_TOUCH_FEEDBACK])
+
+
+async def setup_touch_feedback(var, config):
+    cg.add_define("USE_IT8951E_TOUCH_FEEDBACK")
+    cg.add(var.set_feedback_mode(config[CONF_MODE]))
+
+    listener = cg.new_Pvariable(config[CONF_ID], var)
+    touch = await cg.get_variable(config[CONF_TOUCHSCREEN_ID])
+    cg.add(touch.register_listener(listener))
+
+    # the touchscreen binary sensors on this touchscreen are the widgets
+    for conf in CORE.config.get("binary_sensor", []):
+        if conf.get(CONF_PLATFORM) != "touchscreen":
+            continue
+        if conf[CONF_TOUCHSCREEN_ID].id != config[CONF_TOUCHSCREEN_ID].id:
+            continue
+        page = cg.nullptr
+        if CONF_PAGE_ID in conf:
+            page = await cg.get_variable(conf[CONF_PAGE_ID])
+        cg.add(
+            var.add_feedback_area(
+                conf[CONF_X_MIN], conf[CONF_X_MAX], conf[CONF_Y_MIN], conf[CONF_Y_MAX], page
+            )
+        )
\ No newline at end of file
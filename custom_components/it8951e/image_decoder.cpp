@@ -0,0 +1,160 @@
+#include "it8951e.h"
+
+#ifdef USE_IT8951E_IMAGE_DECODER
+
+#include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
+#include <JPEGDEC.h>
+#include <PNGdec.h>
+#include <algorithm>
+
+namespace esphome {
+namespace it8951e {
+
+static const char *const TAG = "it8951e.decoder";
+
+// PNG lines are collected into strips so every upload covers several rows
+static const uint8_t PNG_STRIP_ROWS = 16;
+
+struct DecodeContext {
+  IT8951ESensor *display;
+  int x;
+  int y;
+  int width;
+  int height;
+  PNG *png;
+  uint16_t *line;
+  uint8_t *strip;
+  int strip_y;
+  int strip_rows;
+};
+
+static int jpeg_draw(JPEGDRAW *draw) {
+  auto *ctx = static_cast<DecodeContext *>(draw->pUser);
+  // the last MCU column and row can reach past the image edge
+  int w = std::min<int>(draw->iWidth, ctx->width - draw->x);
+  int h = std::min<int>(draw->iHeight, ctx->height - draw->y);
+  ctx->display->draw_gray_block(ctx->x + draw->x, ctx->y + draw->y, w, h,
+                                reinterpret_cast<const uint8_t *>(draw->pPixels), draw->iWidth);
+  return 1;
+}
+
+static void png_flush_strip(DecodeContext *ctx) {
+  if (ctx->strip_rows == 0) {
+    return;
+  }
+  ctx->display->draw_gray_block(ctx->x, ctx->y + ctx->strip_y, ctx->width, ctx->strip_rows, ctx->strip, ctx->width);
+  ctx->strip_rows = 0;
+}
+
+static void png_draw(PNGDRAW *draw) {
+  auto *ctx = static_cast<DecodeContext *>(draw->pUser);
+  ctx->png->getLineAsRGB565(draw, ctx->line, PNG_RGB565_LITTLE_ENDIAN, 0xffffffff);
+
+  if (ctx->strip_rows == 0) {
+    ctx->strip_y = draw->y;
+  }
+  uint8_t *gray = ctx->strip + ctx->strip_rows * ctx->width;
+  for (int i = 0; i < ctx->width; i++) {
+    uint16_t c = ctx->line[i];
+    uint8_t r = (c >> 8) & 0xF8;
+    uint8_t g = (c >> 3) & 0xFC;
+    uint8_t b = (c << 3) & 0xF8;
+    gray[i] = (r * 77 + g * 150 + b * 29) >> 8;
+  }
+  ctx->strip_rows++;
+
+  if (ctx->strip_rows == PNG_STRIP_ROWS || draw->y == ctx->height - 1) {
+    png_flush_strip(ctx);
+  }
+}
+
+/** @brief Decode a JPEG or PNG image straight into the controller
+ * The image is decoded in MCU rows or strips of lines, each chunk is
+ * converted to 16 grays and uploaded as soon as it is produced, so the
+ * decoded image never exists in RAM. YAML reaches it through the
+ * IT8951E.draw_image action, which embeds the file in flash.
+ * @param data encoded image
+ * @param length size of data
+ * @param x X coordinate in rotated display coordinates
+ * @param y Y coordinate in rotated display coordinates
+ * @retval true when the image was decoded
+ */
+bool IT8951ESensor::draw_encoded_image(const uint8_t *data, size_t length, int x, int y) {
+  if (this->device_info_ == nullptr || this->buffer_ == nullptr || length < 4) {
+    return false;
+  }
+  if (data[0] == 0xFF && data[1] == 0xD8) {
+    return this->decode_jpeg_(data, length, x, y);
+  }
+  if (data[0] == 0x89 && data[1] == 'P' && data[2] == 'N' && data[3] == 'G') {
+    return this->decode_png_(data, length, x, y);
+  }
+  ESP_LOGE(TAG, "Unknown image format.");
+  return false;
+}
+
+bool IT8951ESensor::decode_jpeg_(const uint8_t *data, size_t length, int x, int y) {
+  auto *jpeg = new JPEGDEC();  // NOLINT(cppcoreguidelines-owning-memory)
+  if (!jpeg->openRAM(const_cast<uint8_t *>(data), length, jpeg_draw)) {
+    ESP_LOGE(TAG, "Could not open JPEG image.");
+    delete jpeg;  // NOLINT(cppcoreguidelines-owning-memory)
+    return false;
+  }
+
+  DecodeContext ctx{this, x, y, jpeg->getWidth(), jpeg->getHeight(), nullptr, nullptr, nullptr, 0, 0};
+  jpeg->setUserPointer(&ctx);
+  jpeg->setPixelType(EIGHT_BIT_GRAYSCALE);
+  bool ok = jpeg->decode(0, 0, 0);
+  jpeg->close();
+  delete jpeg;  // NOLINT(cppcoreguidelines-owning-memory)
+
+  if (ok) {
+    this->refresh_image_area_(x, y, ctx.width, ctx.height);
+  }
+  return ok;
+}
+
+bool IT8951ESensor::decode_png_(const uint8_t *data, size_t length, int x, int y) {
+  auto *png = new PNG();  // NOLINT(cppcoreguidelines-owning-memory)
+  if (png->openRAM(const_cast<uint8_t *>(data), length, png_draw) != PNG_SUCCESS) {
+    ESP_LOGE(TAG, "Could not open PNG image.");
+    delete png;  // NOLINT(cppcoreguidelines-owning-memory)
+    return false;
+  }
+
+  int width = png->getWidth();
+  int height = png->getHeight();
+  ExternalRAMAllocator<uint16_t> line_allocator(ExternalRAMAllocator<uint16_t>::ALLOW_FAILURE);
+  ExternalRAMAllocator<uint8_t> strip_allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+  uint16_t *line = line_allocator.allocate(width);
+  uint8_t *strip = strip_allocator.allocate(width * PNG_STRIP_ROWS);
+
+  bool ok = false;
+  if (line == nullptr || strip == nullptr) {
+    ESP_LOGE(TAG, "Not enough memory to decode PNG image.");
+  } else {
+    DecodeContext ctx{this, x, y, width, height, png, line, strip, 0, 0};
+    ok = png->decode(&ctx, 0) == PNG_SUCCESS;
+    png_flush_strip(&ctx);
+  }
+  png->close();
+  delete png;  // NOLINT(cppcoreguidelines-owning-memory)
+
+  if (line != nullptr) {
+    line_allocator.deallocate(line, width);
+  }
+  if (strip != nullptr) {
+    strip_allocator.deallocate(strip, width * PNG_STRIP_ROWS);
+  }
+
+  if (ok) {
+    this->refresh_image_area_(x, y, width, height);
+  }
+  return ok;
+}
+
+}  // namespace it8951e
+}  // namespace esphome
+
+#endif  // USE_IT8951E_IMAGE_DECODER
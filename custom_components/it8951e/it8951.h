@@ -44,6 +44,9 @@ IT8951 Command defines
 /*-----------------------------------------------------------------------
 IT8951 Registers defines
 ------------------------------------------------------------------------*/
+//Size of the built in SDRAM holding the image buffers
+#define IT8951_SDRAM_SIZE           0x800000
+
 //Register Base Address
 #define IT8951_DISPLAY_REG_BASE     0x1000 //Register RW access
 
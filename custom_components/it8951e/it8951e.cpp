@@ -3,15 +3,36 @@
 #include "it8951.h"
 #include "esphome/core/application.h"
 #include "esphome/core/gpio.h"
+#include "esphome/core/helpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef USE_SPI_DMA_BACKEND
+#include <esp_heap_caps.h>
+#endif
 
 namespace esphome {
 namespace it8951e {
 
 
-#define M5EPD_PANEL_W 960
-#define M5EPD_PANEL_H 540
 static const char *TAG = "it8951e.display";
 
+// rows per image load when an upload is split into bus transactions, two bands are kept in DMA memory
+static const uint16_t UPLOAD_BAND_ROWS = 30;
+// 16 bit words staged per pixel write, one full row of the M5Paper panel
+static const uint16_t ROW_WORDS = M5EPD_PANEL_W / 4;
+#ifdef USE_IT8951E_RENDER_TASK
+// a band keeps a row of words on the stack under the SPI driver and the log calls, 4 KiB left too little headroom
+static const uint32_t RENDER_TASK_STACK_SIZE = 6144;
+#endif
+// the levels DU4 can show, 0, 5, 10 and 15, one bit per level
+static const uint16_t DU4_LEVELS = 0x8421;
+
+// data rates tried by the calibration, slowest first
+static const uint32_t CALIBRATION_RATES[] = {10000000, 16000000, 20000000, 26666666, 40000000};
+static const uint16_t CALIBRATION_WORDS = 256;
+
 void IT8951ESensor::write_two_byte16(uint16_t type, uint16_t cmd) {
     this->enable_cs();
 
@@ -61,9 +82,8 @@ void IT8951ESensor::write_word(uint16_t cmd) {
 }
 
 void IT8951ESensor::write_reg(uint16_t addr, uint16_t data) {
-    this->write_command(0x0011);  // tcon write reg command
-    this->write_word(addr);
-    this->write_word(data);
+    uint16_t args[2] = {addr, data};
+    this->write_args(IT8951_TCON_REG_WR, args, 2);
 }
 
 void IT8951ESensor::set_target_memory_addr(uint32_t tar_addr) {
@@ -74,11 +94,22 @@ void IT8951ESensor::set_target_memory_addr(uint32_t tar_addr) {
     this->write_reg(IT8951_LISAR, l);
 }
 
-void IT8951ESensor::write_args(uint16_t cmd, uint16_t *args, uint16_t length) {
+/** @brief Send a command and its arguments as two transactions
+ * The controller accepts any number of data words behind a single write
+ * preamble, HRDY only has to be polled before and after the preamble.
+ */
+void IT8951ESensor::write_args(uint16_t cmd, const uint16_t *args, uint16_t length) {
     this->write_command(cmd);
-    for (uint16_t i = 0; i < length; i++) {
-        this->write_word(args[i]);
-    }
+    this->begin_data_burst_();
+    this->write_array16(args, length);
+    this->disable_cs();
+}
+
+void IT8951ESensor::begin_data_burst_() {
+    this->wait_busy();
+    this->enable_cs();
+    this->write_byte16(0x0000);
+    this->wait_busy();
 }
 
 void IT8951ESensor::set_area(uint16_t x, uint16_t y, uint16_t w,
@@ -99,34 +130,68 @@ void IT8951ESensor::wait_busy(uint32_t timeout) {
             return;
         }
 
-        if (millis() - start_time > timeout) {
+        uint32_t waited = millis() - start_time;
+        if (waited > timeout) {
             ESP_LOGE(TAG, "Pin busy timeout");
             return;
         }
+        // HRDY is usually back within microseconds, only long waits give up the CPU
+        if (waited > 1) {
+            this->yield_from_task_();
+        }
     }
 }
 
+/** @brief Map 8 bit luma to the 16 panel gray levels once, drawing is a table lookup
+ * The frame buffer holds ink levels, 0 is paper and 15 full ink, which
+ * write_packed_row_() turns into panel levels. Luma 255 is white, so it
+ * maps to no ink, unless color_on_is_ink_ turns that around for lambdas
+ * that draw in COLOR_ON on COLOR_OFF like on a monochrome display.
+ */
+void IT8951ESensor::build_gray_lut_() {
+    for (uint16_t i = 0; i < 256; i++) {
+        float level = powf(i / 255.0f, this->gamma_) * 15.0f;
+        uint8_t ink = 15 - (uint8_t) clamp<int>(lroundf(level), 0, 15);
+        this->gray_lut_[i] = this->color_on_is_ink_ ? 15 - ink : ink;
+    }
+}
+
+bool IT8951ESensor::is_lut_busy_() {
+    uint16_t reg = IT8951_LUTAFSR;
+    // every poll takes the bus on its own, other devices get it in between
+    this->enable();
+    this->write_args(IT8951_TCON_REG_RD, &reg, 1);
+    bool busy = this->read_word() != 0;
+    this->disable();
+    return busy;
+}
+
 void IT8951ESensor::check_busy(uint32_t timeout) {
     uint32_t start_time = millis();
-    while (1) {
-        this->write_command(IT8951_TCON_REG_RD);
-        this->write_word(IT8951_LUTAFSR);
-        uint16_t word = this->read_word();
-        if (word == 0) {
-            break;
-        }
-
+    while (this->is_lut_busy_()) {
         if (millis() - start_time > timeout) {
-            ESP_LOGE(TAG, "SPI busy timeout %i", word);
+            ESP_LOGE(TAG, "SPI busy timeout");
             return;
         }
+        this->yield_from_task_();
+    }
+}
 
+/** @brief Give up the CPU while polling the controller from the render task
+ * The task runs above the idle task of core 0, spinning there for a whole
+ * waveform would starve it and trip the task watchdog.
+ */
+void IT8951ESensor::yield_from_task_() {
+#ifdef USE_IT8951E_RENDER_TASK
+    if (this->render_task_ != nullptr && xTaskGetCurrentTaskHandle() == this->render_task_) {
+        vTaskDelay(1);
     }
+#endif
 }
 
 
 void IT8951ESensor::update_area(uint16_t x, uint16_t y, uint16_t w,
-                                     uint16_t h, m5epd_update_mode_t mode) {
+                                     uint16_t h, m5epd_update_mode_t mode, uint32_t addr) {
     if (mode == UPDATE_MODE_NONE) {
         return;
     }
@@ -146,8 +211,8 @@ void IT8951ESensor::update_area(uint16_t x, uint16_t y, uint16_t w,
     args[2] = w;
     args[3] = h;
     args[4] = mode;
-    args[5] = this->device_info_->usImgBufAddrL;
-    args[6] = this->device_info_->usImgBufAddrH;
+    args[5] = (uint16_t)(addr & 0x0000FFFF);
+    args[6] = (uint16_t)((addr >> 16) & 0x0000FFFF);
 
     this->enable();
     this->write_args(IT8951_I80_CMD_DPY_BUF_AREA, args, 7);
@@ -191,6 +256,104 @@ void IT8951ESensor::read_words(void *buf, uint32_t length) {
     this->disable_cs();
 }
 
+/// Write words into controller memory with a single burst
+void IT8951ESensor::write_memory_burst_(uint32_t addr, const uint16_t *data, uint16_t length) {
+    uint16_t args[4] = {(uint16_t) addr, (uint16_t)(addr >> 16), length, 0};
+    this->write_args(IT8951_TCON_MEM_BST_WR, args, 4);
+    this->begin_data_burst_();
+    this->write_array16(data, length);
+    this->disable_cs();
+    this->write_command(IT8951_TCON_MEM_BST_END);
+}
+
+/// Read words from controller memory with a single burst
+void IT8951ESensor::read_memory_burst_(uint32_t addr, uint16_t *data, uint16_t length) {
+    uint16_t args[4] = {(uint16_t) addr, (uint16_t)(addr >> 16), length, 0};
+    this->write_args(IT8951_TCON_MEM_BST_RD_T, args, 4);
+    this->write_command(IT8951_TCON_MEM_BST_RD_S);
+
+    this->wait_busy();
+    this->enable_cs();
+    this->write_byte16(0x1000);
+    this->wait_busy();
+
+    // dummy
+    this->transfer_byte(0);
+    this->transfer_byte(0);
+    this->wait_busy();
+
+    for (uint16_t i = 0; i < length; i++) {
+        data[i] = this->transfer_byte(0x00) << 8;
+        data[i] |= this->transfer_byte(0x00);
+    }
+    this->disable_cs();
+
+    this->write_command(IT8951_TCON_MEM_BST_END);
+}
+
+/// Write a test pattern to scratch memory at the given rate and check it reads back unchanged
+bool IT8951ESensor::verify_data_rate_(uint32_t data_rate, uint32_t addr) {
+    uint16_t pattern[CALIBRATION_WORDS];
+    uint16_t readback[CALIBRATION_WORDS];
+    for (uint16_t i = 0; i < CALIBRATION_WORDS; i++) {
+        // every other word flips all bits, the rest walks through mixed patterns
+        uint16_t word = i * 0x9E37 + 0x1234;
+        pattern[i] = (i & 1) ? ~word : word;
+    }
+
+    this->set_data_rate(data_rate);
+    this->enable();
+    this->write_memory_burst_(addr, pattern, CALIBRATION_WORDS);
+    this->read_memory_burst_(addr, readback, CALIBRATION_WORDS);
+    this->disable();
+
+    return memcmp(pattern, readback, sizeof(pattern)) == 0;
+}
+
+/** @brief Find the fastest data rate the wiring can take
+ * Test patterns are written to the first page slot behind the image buffer,
+ * which is still unused at setup, and read back at increasing rates up to the
+ * configured data rate, which stays the ceiling. The rate one step below the
+ * fastest one that verified is used, so there is some margin for temperature
+ * and supply changes.
+ */
+void IT8951ESensor::calibrate_data_rate() {
+    uint32_t fallback = this->get_data_rate();
+    uint32_t addr = this->image_buffer_addr_() + this->get_width_internal() * this->get_height_internal();
+
+    if (CALIBRATION_RATES[0] > this->max_data_rate_) {
+        ESP_LOGW(TAG, "Max data rate %.2f MHz is below the slowest probe rate, keeping %.2f MHz.",
+                 this->max_data_rate_ / 1e6f, fallback / 1e6f);
+        return;
+    }
+
+    int passed = -1;
+    for (size_t i = 0; i < sizeof(CALIBRATION_RATES) / sizeof(CALIBRATION_RATES[0]); i++) {
+        if (CALIBRATION_RATES[i] > this->max_data_rate_ || !this->verify_data_rate_(CALIBRATION_RATES[i], addr)) {
+            break;
+        }
+        passed = i;
+    }
+
+    if (passed < 0) {
+        ESP_LOGW(TAG, "Slowest probe rate %.2f MHz failed, keeping %.2f MHz.", CALIBRATION_RATES[0] / 1e6f,
+                 fallback / 1e6f);
+        this->set_data_rate(fallback);
+        return;
+    }
+
+    // step one rate down from the fastest verified one for margin, unless only the slowest rate passed
+    uint32_t rate = CALIBRATION_RATES[passed > 0 ? passed - 1 : 0];
+    this->set_data_rate(rate);
+    this->data_rate_calibrated_ = true;
+    if (passed == 0) {
+        ESP_LOGW(TAG, "Only the slowest probe rate %.2f MHz verified, using it without margin.", rate / 1e6f);
+    } else {
+        ESP_LOGD(TAG, "Fastest verified data rate %.2f MHz, using %.2f MHz.", CALIBRATION_RATES[passed] / 1e6f,
+                 rate / 1e6f);
+    }
+}
+
 uint32_t IT8951ESensor::get_buffer_length_() { return this->get_width_internal() * this->get_height_internal(); }
 
 void IT8951ESensor::get_device_info(IT8951DevInfo *info) {
@@ -218,6 +381,7 @@ void IT8951ESensor::setup() {
     ExternalRAMAllocator<IT8951DevInfo> allocator(ExternalRAMAllocator<IT8951DevInfo>::ALLOW_FAILURE);
     this->device_info_ = allocator.allocate(1);
     if (this->device_info_ == nullptr) {
+        this->disable();
         ESP_LOGE(TAG, "Init FAILED.");
         return;
     }
@@ -228,22 +392,65 @@ void IT8951ESensor::setup() {
     this->write_reg(IT8951_I80CPCR, 0x0001);
 
     // set vcom to -2.30v
-    this->write_command(IT8951_I80_CMD_VCOM); // tcon vcom set command
-    this->write_word(0x0001);
-    this->write_word(2300);
+    uint16_t vcom[2] = {0x0001, 2300};
+    this->write_args(IT8951_I80_CMD_VCOM, vcom, 2); // tcon vcom set command
 
     get_device_info(this->device_info_);
+    this->panel_w_ = this->device_info_->usPanelW;
+    this->panel_h_ = this->device_info_->usPanelH;
+    this->stride_ = this->panel_w_ >> 1;
 
-    ExternalRAMAllocator<uint8_t> buffer_allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
-    this->should_write_buffer_ = buffer_allocator.allocate(this->get_buffer_length_());
-    if (this->should_write_buffer_ == nullptr) {
-        ESP_LOGE(TAG, "Init FAILED.");
-        return;
+    this->disable();
+
+#ifdef USE_SPI_DMA_BACKEND
+    for (auto &band : this->band_buffers_) {
+        band = (uint8_t *) heap_caps_malloc(UPLOAD_BAND_ROWS * ROW_WORDS * 2, MALLOC_CAP_DMA);
+    }
+    if (this->band_buffers_[0] == nullptr || this->band_buffers_[1] == nullptr) {
+        ESP_LOGW(TAG, "Not enough DMA memory, uploading without background writes.");
+        for (auto &band : this->band_buffers_) {
+            heap_caps_free(band);
+            band = nullptr;
+        }
     }
+#endif
 
-    this->disable();
+    if (this->calibrate_data_rate_.value()) {
+        this->calibrate_data_rate();
+    }
+
+#ifdef USE_IT8951E_RENDER_TASK
+    if (this->use_render_task_) {
+        ExternalRAMAllocator<uint8_t> buffer_allocator(ExternalRAMAllocator<uint8_t>::ALLOW_FAILURE);
+        this->front_buffer_ = buffer_allocator.allocate(this->get_buffer_length_() >> 1);
+        if (this->front_buffer_ == nullptr) {
+            ESP_LOGE(TAG, "Init FAILED.");
+            return;
+        }
+        if (!this->feedback_areas_.empty()) {
+            this->feedback_buffer_ = buffer_allocator.allocate(this->get_buffer_length_() >> 1);
+            if (this->feedback_buffer_ == nullptr) {
+                ESP_LOGW(TAG, "Not enough memory for touch feedback.");
+            }
+        }
+        this->upload_done_ = xSemaphoreCreateBinary();
+        // the main loop runs on core 1, uploads go to core 0
+        xTaskCreatePinnedToCore(render_task_loop_, "it8951e", RENDER_TASK_STACK_SIZE, this, 1, &this->render_task_, 0);
+    }
+#endif
+
+    // every cached page needs a full 8bpp frame behind the main image buffer
+    uint32_t frame_size = this->get_width_internal() * this->get_height_internal();
+    uint32_t free_slots = (IT8951_SDRAM_SIZE - this->image_buffer_addr_()) / frame_size - 1;
+    if (this->page_cache_size_ > free_slots) {
+        ESP_LOGW(TAG, "Only %u page slots fit in controller memory.", free_slots);
+        this->page_cache_size_ = free_slots;
+    }
+    this->page_slots_.reserve(this->page_cache_size_);
 
+    this->build_gray_lut_();
     this->init_internal_(this->get_buffer_length_());
+    this->select_pixel_writer_();
 
     ESP_LOGE(TAG, "Init SUCCESS.");
 }
@@ -251,55 +458,192 @@ void IT8951ESensor::setup() {
 /** @brief Write the image at the specified location, Partial update
  * @param x Update X coordinate, >>> Must be a multiple of 4 <<<
  * @param y Update Y coordinate
- * @param w width of gram, >>> Must be a multiple of 4 <<<
- * @param h height of gram
- * @param gram 4bpp garm data
+ * @param w width of the area, >>> Must be a multiple of 4 <<<
+ * @param h height of the area
+ * @param gram 4bpp frame buffer, rows are read with the full panel stride
+ * @param addr Controller memory address of the target image buffer
+ * @param invert Upload the inverse of the buffer contents
  * @retval m5epd_err_t
  */
 void IT8951ESensor::write_buffer_to_display(uint16_t x, uint16_t y, uint16_t w,
-                                            uint16_t h, const uint8_t *gram) {
+                                            uint16_t h, const uint8_t *gram, uint32_t addr, bool invert) {
     if (x > this->get_width_internal() || y > this->get_height_internal()) {
         ESP_LOGE(TAG, "Pos (%d, %d) out of bounds.", x, y);
         return;
     }
 
+    this->begin_image_load_(x, y, w, h, addr);
+
+    const uint32_t stride = this->get_width_internal() >> 1;
+    for (uint16_t row = 0; row < h; row++) {
+        this->write_packed_row_(gram + (y + row) * stride + (x >> 1), w >> 1, invert);
+    }
+
+    this->end_image_load_();
+}
+
+/// Start an image load, pixel data is streamed in a single burst until end_image_load_()
+void IT8951ESensor::begin_image_load_(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t addr) {
     this->enable();
-    this->set_target_memory_addr(this->device_info_->usImgBufAddrL | (this->device_info_->usImgBufAddrH << 16));
+    this->set_target_memory_addr(addr);
     this->set_area(x, y, w, h);
+    this->begin_data_burst_();
+}
 
-    uint32_t pos = 0;
-    uint16_t word = 0;
-    for (uint32_t x = 0; x < ((w * h) >> 2); x++) {
-        word = gram[pos] << 8 | gram[pos + 1];
+/** @brief Write one row of packed 4bpp pixels, length must be a multiple of 2 bytes
+ * A full row of the M5Paper panel goes out as a single write, so the DMA
+ * backend sends it as one transaction instead of one per few words.
+ */
+void IT8951ESensor::write_packed_row_(const uint8_t *line, uint16_t length, bool invert) {
+    uint16_t words[ROW_WORDS];
+    uint16_t count = 0;
+    for (uint16_t pos = 0; pos < length; pos += 2) {
+        uint16_t word = line[pos] << 8 | line[pos + 1];
 
-        if (!this->reversed_) {
+        if (this->reversed_ == invert) {
             word = 0xFFFF - word;
         }
 
-        this->enable_cs();
-        this->write_byte32(word);
-        this->disable_cs();
-        pos += 2;
+        words[count++] = word;
+        if (count == ROW_WORDS) {
+            this->write_array16(words, count);
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        this->write_array16(words, count);
     }
+}
 
+void IT8951ESensor::end_image_load_() {
+    this->disable_cs();
     this->write_command(IT8951_TCON_LD_IMG_END);
     this->disable();
 }
 
+/** @brief Upload a band of rows and return while it is still on the wire
+ * The band is copied in wire order into the DMA buffer the band before is
+ * not using and sent in the background, done runs once its image load has
+ * ended. That is from the SPI loop for the main loop, or from the next bus
+ * access of the calling task. Without DMA the band is written right away.
+ */
+void IT8951ESensor::write_band_(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t *gram, uint32_t addr,
+                                bool invert, std::function<void()> &&done) {
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->band_buffers_[0] != nullptr && h <= UPLOAD_BAND_ROWS) {
+        uint8_t *band = this->band_buffers_[this->band_slot_];
+        this->band_slot_ ^= 1;
+        // words go out high byte first, which is the byte order of the frame buffer
+        const uint16_t length = w >> 1;
+        for (uint16_t row = 0; row < h; row++) {
+            const uint8_t *line = gram + (y + row) * this->stride_ + (x >> 1);
+            uint8_t *out = band + row * length;
+            if (this->reversed_ == invert) {
+                for (uint16_t i = 0; i < length; i++) {
+                    out[i] = ~line[i];
+                }
+            } else {
+                memcpy(out, line, length);
+            }
+        }
+
+        // the band before ends its image load here, other devices get the bus in between
+        this->wait_async_write();
+        this->begin_image_load_(x, y, w, h, addr);
+        this->write_array_async(band, length * h, [this, done]() {
+            this->end_image_load_();
+            if (done) {
+                done();
+            }
+        });
+        return;
+    }
+#endif
+    this->write_buffer_to_display(x, y, w, h, gram, addr, invert);
+    if (done) {
+        done();
+    }
+}
+
 void IT8951ESensor::write_display() {
  if (this->device_info_ == nullptr) {
   return;
  }
 
+ if (this->min_x > this->max_x || this->min_y > this->max_y) {
+  // nothing was drawn since the last write
+  return;
+ }
+
+ // image loads and refreshes work on 4 pixel aligned columns
+ uint16_t x = this->min_x & ~0x3;
+ uint16_t y = this->min_y;
+ uint16_t w = ((this->max_x + 4) & ~0x3) - x;
+ uint16_t h = this->max_y - this->min_y + 1;
+
  //this->write_command(IT8951_TCON_SYS_RUN);
- this->write_buffer_to_display(0, 0, this->max_x, this->max_y, this->buffer_);
- this->update_area(0, 0, this->max_x, this->max_y, UPDATE_MODE_DU4);
+ this->upload_area_(x, y, w, h, this->image_buffer_addr_(), this->frame_mode_(x, y, w, h));
 
+ this->min_x = UINT32_MAX;
+ this->min_y = UINT32_MAX;
  this->max_x = 0;
  this->max_y = 0;
  //this->write_command(IT8951_TCON_SLEEP);
 }
 
+/** @brief Upload part of the frame buffer and refresh it as bus transactions
+ * The area is split into bands of rows, every band is an image load of its
+ * own so transactions of other devices on the bus can run in between. The
+ * refresh is queued behind the last band. Without a transaction queue on
+ * the bus everything runs right away.
+ */
+void IT8951ESensor::upload_area_(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t addr,
+                                 m5epd_update_mode_t mode, bool upload) {
+#ifdef USE_IT8951E_RENDER_TASK
+    if (this->render_task_ != nullptr) {
+        // every upload is out here, so the task is not reading the front buffer
+        if (upload) {
+            for (uint16_t row = y; row < y + h; row++) {
+                uint32_t offset = row * this->stride_ + (x >> 1);
+                memcpy(this->front_buffer_ + offset, this->buffer_ + offset, w >> 1);
+            }
+        }
+        if (this->render_jobs_.push(RenderJob{x, y, w, h, addr, (uint8_t) mode, upload, false})) {
+            this->uploads_in_flight_++;
+            this->uploads_submitted_++;
+            xTaskNotifyGive(this->render_task_);
+        } else {
+            ESP_LOGW(TAG, "Render queue full, dropping frame.");
+        }
+        return;
+    }
+#endif
+
+    for (uint16_t row = 0; upload && row < h; row += UPLOAD_BAND_ROWS) {
+        uint16_t rows = std::min<uint16_t>(UPLOAD_BAND_ROWS, h - row);
+        this->uploads_in_flight_++;
+        this->submit([this, x, y, w, row, rows, addr]() {
+            this->write_band_(x, y + row, w, rows, this->buffer_, addr, false, [this]() { this->uploads_in_flight_--; });
+        });
+    }
+
+    if (mode != UPDATE_MODE_NONE) {
+        uint32_t start = millis();
+        this->uploads_in_flight_++;
+        this->submit([this, x, y, w, h, addr, mode, start]() {
+            // the bands of this device run in order, only the last one may still be on the wire
+            this->wait_async_write();
+            this->stage_callback_.call(FRAME_STAGE_UPLOAD_DONE, micros());
+            this->update_area(x, y, w, h, mode, addr);
+            this->uploads_in_flight_--;
+            this->frame_callback_.call(millis() - start);
+            if (this->track_stages_) {
+                this->wait_lut_done_();
+            }
+        });
+    }
+}
+
 
 /** @brief Clear graphics buffer
  * @param init Screen initialization, If is 0, clear the buffer without
@@ -307,75 +651,619 @@ void IT8951ESensor::write_display() {
  * @retval m5epd_err_t
  */
 void IT8951ESensor::clear(bool init) {
+    this->wait_render_idle_();
     this->enable();
 
-    this->set_target_memory_addr(this->device_info_->usImgBufAddrL | (this->device_info_->usImgBufAddrH << 16));
+    this->set_target_memory_addr(this->image_buffer_addr_());
     this->set_area(0, 0, this->get_width_internal(), this->get_height_internal());    
     uint32_t looping = (this->get_width_internal() * this->get_height_internal()) >> 2;
 
-    for (uint32_t x = 0; x < looping; x++) {
-        this->enable_cs();
-        this->write_byte32(0x0000FFFF);
-        this->disable_cs();
+    uint16_t white[64];
+    std::fill(white, white + 64, 0xFFFF);
+    this->begin_data_burst_();
+    for (uint32_t x = 0; x < looping; x += 64) {
+        this->write_array16(white, std::min<uint32_t>(64, looping - x));
     }
+    this->disable_cs();
 
     this->write_command(IT8951_TCON_LD_IMG_END);
 
     this->disable();
+    this->page_shown_ = false;
 
     if (init) {
-        this->update_area(0, 0, this->get_width_internal(), this->get_height_internal(), UPDATE_MODE_INIT);
+        this->update_area(0, 0, this->get_width_internal(), this->get_height_internal(), UPDATE_MODE_INIT,
+                          this->image_buffer_addr_());
+    }
+}
+
+void IT8951ESensor::rotate_point_(int &x, int &y) {
+    switch (this->rotation_) {
+        case display::DISPLAY_ROTATION_0_DEGREES:
+            break;
+        case display::DISPLAY_ROTATION_90_DEGREES:
+            std::swap(x, y);
+            x = this->get_width_internal() - x - 1;
+            break;
+        case display::DISPLAY_ROTATION_180_DEGREES:
+            x = this->get_width_internal() - x - 1;
+            y = this->get_height_internal() - y - 1;
+            break;
+        case display::DISPLAY_ROTATION_270_DEGREES:
+            std::swap(x, y);
+            y = this->get_height_internal() - y - 1;
+            break;
+    }
+}
+
+/// Convert an inclusive rectangle in rotated coordinates to clamped panel coordinates, x_min 4 pixel aligned
+void IT8951ESensor::to_absolute_area_(int x1, int y1, int x2, int y2, uint32_t &x_min, uint32_t &y_min,
+                                      uint32_t &x_max, uint32_t &y_max) {
+    this->rotate_point_(x1, y1);
+    this->rotate_point_(x2, y2);
+
+    int w_max = this->get_width_internal() - 1;
+    int h_max = this->get_height_internal() - 1;
+    x_min = clamp(std::min(x1, x2), 0, w_max) & ~0x3;
+    y_min = clamp(std::min(y1, y2), 0, h_max);
+    x_max = clamp(std::max(x1, x2), 0, w_max);
+    y_max = clamp(std::max(y1, y2), 0, h_max);
+}
+
+void IT8951ESensor::mark_dirty_(uint32_t x_min, uint32_t y_min, uint32_t x_max, uint32_t y_max) {
+    this->min_x = std::min(this->min_x, x_min);
+    this->min_y = std::min(this->min_y, y_min);
+    this->max_x = std::max(this->max_x, x_max);
+    this->max_y = std::max(this->max_y, y_max);
+}
+
+/** @brief Flash the touched widget straight away
+ * Uploads the inverse of the widget rectangle and refreshes only that area
+ * with a fast monochrome waveform. The area is marked dirty so the next
+ * regular update restores it with full quality. With the render task the
+ * upload is handed over ahead of any queued frame, the main loop never
+ * waits for a refresh in progress.
+ */
+void IT8951ESensor::touch_feedback(uint16_t x, uint16_t y) {
+    if (this->feedback_active_ || this->device_info_ == nullptr || this->buffer_ == nullptr) {
+        return;
+    }
+
+    for (auto &area : this->feedback_areas_) {
+        if (x < area.x_min || x > area.x_max || y < area.y_min || y > area.y_max) {
+            continue;
+        }
+        if (area.page != nullptr && area.page != this->page_) {
+            continue;
+        }
+
+        uint32_t ax_min, ay_min, ax_max, ay_max;
+        this->to_absolute_area_(area.x_min, area.y_min, area.x_max, area.y_max, ax_min, ay_min, ax_max, ay_max);
+        uint16_t w = ((ax_max + 4) & ~0x3) - ax_min;
+        uint16_t h = ay_max - ay_min + 1;
+
+        this->feedback_active_ = true;
+#ifdef USE_IT8951E_RENDER_TASK
+        if (this->render_task_ != nullptr) {
+            // the task may be busy with a frame for a while, the feedback jumps the queue instead of waiting
+            if (this->feedback_in_flight_ || this->feedback_buffer_ == nullptr) {
+                return;
+            }
+            for (uint16_t row = ay_min; row < ay_min + h; row++) {
+                uint32_t offset = row * this->stride_ + (ax_min >> 1);
+                memcpy(this->feedback_buffer_ + offset, this->buffer_ + offset, w >> 1);
+            }
+            RenderJob job{(uint16_t) ax_min, (uint16_t) ay_min, w, h, this->image_buffer_addr_(),
+                          this->feedback_mode_, true, true};
+            if (this->feedback_jobs_.push(job)) {
+                this->feedback_in_flight_ = true;
+                this->uploads_in_flight_++;
+                this->uploads_submitted_++;
+                xTaskNotifyGive(this->render_task_);
+            }
+            this->page_shown_ = false;
+            this->mark_dirty_(ax_min, ay_min, ax_max, ay_max);
+            return;
+        }
+#endif
+        this->wait_render_idle_();
+        this->write_buffer_to_display(ax_min, ay_min, w, h, this->buffer_, this->image_buffer_addr_(), true);
+        this->update_area(ax_min, ay_min, w, h, (m5epd_update_mode_t) this->feedback_mode_,
+                          this->image_buffer_addr_());
+        this->page_shown_ = false;
+        this->mark_dirty_(ax_min, ay_min, ax_max, ay_max);
+        return;
+    }
+}
+
+/** @brief Draw a block of 8 bit gray pixels and upload it right away
+ * @param x X coordinate of the block in rotated display coordinates
+ * @param y Y coordinate of the block in rotated display coordinates
+ * @param w width of the block
+ * @param h height of the block
+ * @param gray 8 bit gray pixels
+ * @param stride distance between rows in gray
+ * The block is not refreshed, call refresh_image_area_() once the whole image is uploaded.
+ */
+void IT8951ESensor::draw_gray_block(int x, int y, int w, int h, const uint8_t *gray, int stride) {
+    if (this->device_info_ == nullptr || this->buffer_ == nullptr || w <= 0 || h <= 0) {
+        return;
+    }
+
+    // queued bands of the previous frame still read the frame buffer, they have to go out first
+    this->wait_render_idle_();
+
+    // clip the columns once, then walk each row on the panel from its rotated start
+    int col_start = std::max(0, -x);
+    int col_end = std::min(w, this->get_width() - x);
+    int row_start = std::max(0, -y);
+    int row_end = std::min(h, this->get_height() - y);
+    if (col_start >= col_end || row_start >= row_end) {
+        return;
     }
+    int dx = 0, dy = 0;
+    switch (this->rotation_) {
+        case display::DISPLAY_ROTATION_0_DEGREES:
+            dx = 1;
+            break;
+        case display::DISPLAY_ROTATION_90_DEGREES:
+            dy = 1;
+            break;
+        case display::DISPLAY_ROTATION_180_DEGREES:
+            dx = -1;
+            break;
+        case display::DISPLAY_ROTATION_270_DEGREES:
+            dy = -1;
+            break;
+    }
+
+    uint8_t invert = this->color_on_is_ink_ ? 0xFF : 0x00;
+    for (int row = row_start; row < row_end; row++) {
+        const uint8_t *line = gray + row * stride;
+        int px = x + col_start, py = y + row;
+        this->rotate_point_(px, py);
+        for (int col = col_start; col < col_end; col++) {
+            // decoded images are always photometric, whatever the lambdas draw with
+            this->set_level_(px, py, this->gray_lut_[line[col] ^ invert]);
+            px += dx;
+            py += dy;
+        }
+    }
+
+    uint32_t ax_min, ay_min, ax_max, ay_max;
+    this->to_absolute_area_(x, y, x + w - 1, y + h - 1, ax_min, ay_min, ax_max, ay_max);
+    this->write_buffer_to_display(ax_min, ay_min, ((ax_max + 4) & ~0x3) - ax_min, ay_max - ay_min + 1, this->buffer_,
+                                  this->image_buffer_addr_());
+}
+
+/// Refresh an image drawn with draw_gray_block() using the 16 level waveform
+void IT8951ESensor::refresh_image_area_(int x, int y, int w, int h) {
+    uint32_t ax_min, ay_min, ax_max, ay_max;
+    this->to_absolute_area_(x, y, x + w - 1, y + h - 1, ax_min, ay_min, ax_max, ay_max);
+    this->update_area(ax_min, ay_min, ((ax_max + 4) & ~0x3) - ax_min, ay_max - ay_min + 1, UPDATE_MODE_GC16,
+                      this->image_buffer_addr_());
+    this->page_shown_ = false;
 }
 
 void IT8951ESensor::update() {
+    this->update_pending_ = true;
+    this->schedule_update_();
+}
+
+#ifdef USE_IT8951E_RENDER_TASK
+void IT8951ESensor::loop() { this->process_render_events_(); }
+
+/** @brief Body of the render task
+ * Waits for jobs from the main loop, uploads the front buffer and refreshes
+ * the panel. Once the refresh command is out the main loop may write the
+ * controller again, the task alone waits for the waveform to finish before
+ * reporting back.
+ * The bus is shared with the main loop through the SPI bus lock, uploads
+ * go out in bands like queued ones so other devices get the bus in between.
+ * Touch feedback is taken before any queued frame.
+ */
+void IT8951ESensor::render_task_loop_(void *param) {
+    auto *display = static_cast<IT8951ESensor *>(param);
+    RenderJob job;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (true) {
+            display->run_feedback_jobs_();
+            if (!display->render_jobs_.pop(job)) {
+                break;
+            }
+            display->run_render_job_(job);
+        }
+    }
+}
+
+void IT8951ESensor::run_render_job_(const RenderJob &job) {
+    uint32_t start = millis();
+    uint32_t upload_done_us = 0, lut_done_us = 0;
+    if (job.upload) {
+        const uint8_t *source = job.feedback ? this->feedback_buffer_ : this->front_buffer_;
+        for (uint16_t row = 0; row < job.h; row += UPLOAD_BAND_ROWS) {
+            if (!job.feedback) {
+                // feedback that came in meanwhile doesn't wait for the rest of the frame
+                this->run_feedback_jobs_();
+            }
+            uint16_t rows = std::min<uint16_t>(UPLOAD_BAND_ROWS, job.h - row);
+            this->write_band_(job.x, job.y + row, job.w, rows, source, job.addr, job.feedback, nullptr);
+        }
+        this->wait_async_write();
+        upload_done_us = micros();
+    }
+    if (job.mode != UPDATE_MODE_NONE) {
+        this->update_area(job.x, job.y, job.w, job.h, (m5epd_update_mode_t) job.mode, job.addr);
+    }
+    this->uploads_done_.fetch_add(1, std::memory_order_release);
+    xSemaphoreGive(this->upload_done_);
+    if (job.mode != UPDATE_MODE_NONE) {
+        this->check_busy();
+        lut_done_us = micros();
+    }
+    while (!this->render_events_.push(RenderEvent{millis() - start, upload_done_us, lut_done_us, job.feedback})) {
+        vTaskDelay(1);
+    }
+}
+
+void IT8951ESensor::run_feedback_jobs_() {
+    RenderJob job;
+    while (this->feedback_jobs_.pop(job)) {
+        this->run_render_job_(job);
+    }
+}
+
+void IT8951ESensor::process_render_events_() {
+    RenderEvent event;
+    while (this->render_events_.pop(event)) {
+        this->uploads_in_flight_--;
+        if (event.feedback) {
+            // not a frame, nobody listening for frame stages cares
+            this->feedback_in_flight_ = false;
+            continue;
+        }
+        ESP_LOGV(TAG, "Frame done in %u ms, %u bytes of render task stack never used.", event.duration_ms,
+                 uxTaskGetStackHighWaterMark(this->render_task_));
+        // the task can't call back itself, the stages are replayed here with their own timestamps
+        if (event.upload_done_us != 0) {
+            this->stage_callback_.call(FRAME_STAGE_UPLOAD_DONE, event.upload_done_us);
+        }
+        if (event.lut_done_us != 0) {
+            this->stage_callback_.call(FRAME_STAGE_LUT_DONE, event.lut_done_us);
+        }
+        this->frame_callback_.call(event.duration_ms);
+    }
+}
+#endif
+
+/** @brief Block until every pending upload is in controller memory
+ * Direct uploads must not overlap with the render task or land in the
+ * middle of queued bands, which would load the rest of an older frame over
+ * them. The waveform of the last refresh may still be running, whoever
+ * refreshes next waits for it in update_area().
+ */
+void IT8951ESensor::wait_render_idle_() {
+#ifdef USE_IT8951E_RENDER_TASK
+    if (this->render_task_ != nullptr) {
+        while (this->uploads_done_.load(std::memory_order_acquire) != this->uploads_submitted_) {
+            xSemaphoreTake(this->upload_done_, pdMS_TO_TICKS(100));
+        }
+        this->process_render_events_();
+        return;
+    }
+#endif
+    if (this->uploads_in_flight_ > 0) {
+        this->flush_transactions();
+    }
+}
+
+/** @brief Coalesce update requests into as few refreshes as possible
+ * Requests are merged into a single pending update that is rendered when
+ * min_update_interval has passed since the last refresh started and the
+ * panel has finished its previous waveform. The latest request wins, the
+ * dirty area keeps growing until the pending update is written.
+ */
+void IT8951ESensor::schedule_update_() {
+    uint32_t elapsed = millis() - this->last_refresh_ms_;
+    uint32_t wait = 0;
+    if (elapsed < this->min_update_interval_) {
+        wait = this->min_update_interval_ - elapsed;
+    }
+    this->set_timeout("coalesced_update", wait, [this]() { this->flush_update_(); });
+}
+
+void IT8951ESensor::flush_update_() {
+    if (!this->update_pending_ || this->device_info_ == nullptr) {
+        return;
+    }
+
+    if (this->uploads_in_flight_ > 0 || this->is_lut_busy_()) {
+        // the previous upload or refresh is still running, anything queued up
+        // behind it gets merged into this one
+        this->set_timeout("coalesced_update", 20, [this]() { this->flush_update_(); });
+        return;
+    }
+
+    this->render_frame_();
+}
+
+void IT8951ESensor::render_frame_() {
+    this->update_pending_ = false;
+    this->last_refresh_ms_ = millis();
+    this->stage_callback_.call(FRAME_STAGE_UPDATE_START, micros());
+    // the previous frame may have changed the rotation
+    this->select_pixel_writer_();
     this->do_update_();
-    this->write_display();
+    if (this->page_cache_size_ > 0 && this->page_ != nullptr) {
+        this->write_cached_page_();
+    } else {
+        this->write_display();
+    }
 }
 
-void HOT IT8951ESensor::draw_absolute_pixel_internal(int x, int y, Color color) {
-  if (x >= this->get_width_internal() || y >= this->get_height_internal() || x < 0 || y < 0) {
-    ESP_LOGE(TAG, "Drawing outside the screen size!");
+/** @brief Render, upload and refresh without going through the main loop
+ * Meant for boot paths that cut power right after the frame, the queued
+ * bus transactions are run here and the LUT is polled until it is done.
+ */
+void IT8951ESensor::update_now() {
+    if (this->device_info_ == nullptr) {
+        return;
+    }
+    this->cancel_timeout("coalesced_update");
+    this->wait_render_idle_();
+    this->check_busy();
+
+    this->render_frame_();
+    this->flush_transactions();
+    this->wait_render_idle_();
+    this->check_busy();
+}
+
+/** @brief Report the end of the waveform to the stage callbacks
+ * Polls the LUT state every few ms while the bus is free, the reported time
+ * is late by at most one poll interval. Gives up when the next frame
+ * started, that one reports its own stages.
+ */
+void IT8951ESensor::wait_lut_done_() {
+    this->set_timeout("lut_done", 2, [this]() {
+        if (this->uploads_in_flight_ > 0) {
+            return;
+        }
+        if (this->is_lut_busy_()) {
+            this->wait_lut_done_();
+            return;
+        }
+        this->stage_callback_.call(FRAME_STAGE_LUT_DONE, micros());
+    });
+}
+
+/** @brief Show the current page from its own slot in controller memory
+ * Every page gets a full frame slot behind the main image buffer. A slot is
+ * only uploaded again when the rendered page differs from what it holds,
+ * otherwise switching pages is a single DPY_BUF_AREA from the slot.
+ */
+void IT8951ESensor::write_cached_page_() {
+    PageSlot *slot = nullptr;
+    for (auto &candidate : this->page_slots_) {
+        if (candidate.page == this->page_) {
+            slot = &candidate;
+            break;
+        }
+    }
+    uint16_t w = this->get_width_internal();
+    uint16_t h = this->get_height_internal();
+    if (slot == nullptr) {
+        if (this->page_slots_.size() >= this->page_cache_size_) {
+            // the dirty area is relative to the page drawn before, which may be any slot
+            ESP_LOGW(TAG, "No free page slot, writing page uncached.");
+            this->mark_dirty_(0, 0, w - 1, h - 1);
+            this->write_display();
+            this->page_shown_ = false;
+            return;
+        }
+        this->page_slots_.push_back(PageSlot{this->page_, 0, false});
+        slot = &this->page_slots_.back();
+    }
+
+    uint32_t index = slot - this->page_slots_.data();
+    uint32_t addr = this->image_buffer_addr_() + (index + 1) * w * h;
+
+    uint32_t hash = fnv1_hash_(this->buffer_, (w * h) >> 1);
+    bool changed = !slot->valid || slot->hash != hash;
+    bool show = changed || !this->page_shown_ || this->shown_slot_ != index;
+    if (changed || show) {
+        this->upload_area_(0, 0, w, h, addr, show ? this->frame_mode_(0, 0, w, h) : UPDATE_MODE_NONE, changed);
+    }
+    if (changed) {
+        slot->hash = hash;
+        slot->valid = true;
+    }
+
+    if (show) {
+        this->shown_slot_ = index;
+        this->page_shown_ = true;
+    }
+
+    this->min_x = UINT32_MAX;
+    this->min_y = UINT32_MAX;
+    this->max_x = 0;
+    this->max_y = 0;
+}
+
+/** @brief Keep the current frame buffer as a compressed off-screen surface
+ * @param slot Surface number, surfaces are allocated on first use
+ */
+void IT8951ESensor::save_screen(uint8_t slot) {
+    if (this->buffer_ == nullptr) {
+        return;
+    }
+    if (slot >= this->surfaces_.size()) {
+        this->surfaces_.resize(slot + 1);
+    }
+
+    uint32_t length = (this->get_width_internal() * this->get_height_internal()) >> 1;
+    CompressedFrame &surface = this->surfaces_[slot];
+    if (!surface.store(this->buffer_, length)) {
+        ESP_LOGE(TAG, "Not enough memory to save screen %u.", slot);
+        return;
+    }
+    ESP_LOGD(TAG, "Saved screen %u, %u of %u bytes.", slot, surface.size(), surface.raw_size());
+}
+
+/** @brief Show a saved surface
+ * The surface is decoded a row at a time into the frame buffer and each row
+ * is uploaded as soon as it is decoded.
+ */
+void IT8951ESensor::restore_screen(uint8_t slot) {
+    if (this->device_info_ == nullptr || this->buffer_ == nullptr) {
+        return;
+    }
+    if (slot >= this->surfaces_.size() || !this->surfaces_[slot].is_valid()) {
+        ESP_LOGW(TAG, "Screen %u was never saved.", slot);
+        return;
+    }
+
+    uint16_t w = this->get_width_internal();
+    uint16_t h = this->get_height_internal();
+    uint32_t stride = w >> 1;
+    RLEDecoder decoder(this->surfaces_[slot]);
+
+    this->wait_render_idle_();
+    bool gray = false;
+    this->begin_image_load_(0, 0, w, h, this->image_buffer_addr_());
+    for (uint16_t row = 0; row < h; row++) {
+        uint8_t *line = this->buffer_ + row * stride;
+        decoder.read(line, stride);
+        this->write_packed_row_(line, stride, false);
+        gray = gray || needs_gc16_(line, stride);
+    }
+    this->end_image_load_();
+
+    this->update_area(0, 0, w, h, gray ? UPDATE_MODE_GC16 : UPDATE_MODE_DU4, this->image_buffer_addr_());
+    this->page_shown_ = false;
+    this->min_x = UINT32_MAX;
+    this->min_y = UINT32_MAX;
+    this->max_x = 0;
+    this->max_y = 0;
+}
+
+/// True when a row of packed pixels has a level DU4 can't show
+bool IT8951ESensor::needs_gc16_(const uint8_t *line, uint32_t length) {
+    for (uint32_t i = 0; i < length; i++) {
+        if (!((DU4_LEVELS >> (line[i] >> 4)) & (DU4_LEVELS >> (line[i] & 0x0F)) & 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief Pick the waveform for an area of the frame buffer
+ * DU4 only shows four gray levels, areas that use any of the others are
+ * refreshed with GC16 so the 16 level table survives on the panel.
+ */
+IT8951ESensor::m5epd_update_mode_t IT8951ESensor::frame_mode_(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    for (uint16_t row = y; row < y + h; row++) {
+        if (needs_gc16_(this->buffer_ + row * this->stride_ + (x >> 1), w >> 1)) {
+            return UPDATE_MODE_GC16;
+        }
+    }
+    return UPDATE_MODE_DU4;
+}
+
+uint32_t IT8951ESensor::fnv1_hash_(const uint8_t *data, uint32_t length) {
+    uint32_t hash = 2166136261UL;
+    for (uint32_t i = 0; i < length; i++) {
+        hash *= 16777619UL;
+        hash ^= data[i];
+    }
+    return hash;
+}
+
+uint8_t IT8951ESensor::color_to_level_(Color color) {
+  // integer Rec. 601 luma, the weights add up to 256
+  uint8_t luma = (color.r * 77 + color.g * 150 + color.b * 29) >> 8;
+  return this->gray_lut_[luma];
+}
+
+/** @brief Draw a pixel given in rotated display coordinates
+ * Every primitive of DisplayBuffer ends up here. The rotation is resolved
+ * by the writer picked for it, so no pixel goes through a rotation switch.
+ */
+void HOT IT8951ESensor::draw_pixel_at(int x, int y, Color color) {
+  if (this->pixel_writer_ == nullptr || (this->is_clipping() && !this->get_clipping().inside(x, y))) {
+    return;
+  }
+  (this->*pixel_writer_)(x, y, this->color_to_level_(color));
+}
+
+template<display::DisplayRotation ROTATION> void HOT IT8951ESensor::write_pixel_(int x, int y, uint8_t level) {
+  // same mapping as rotate_point_()
+  int px = x, py = y;
+  if (ROTATION == display::DISPLAY_ROTATION_90_DEGREES) {
+    px = this->panel_w_ - y - 1;
+    py = x;
+  } else if (ROTATION == display::DISPLAY_ROTATION_180_DEGREES) {
+    px = this->panel_w_ - x - 1;
+    py = this->panel_h_ - y - 1;
+  } else if (ROTATION == display::DISPLAY_ROTATION_270_DEGREES) {
+    px = y;
+    py = this->panel_h_ - x - 1;
+  }
+  // negative coordinates wrap around and fail the same compare
+  if ((uint32_t) px >= this->panel_w_ || (uint32_t) py >= this->panel_h_) {
     return;
   }
+  this->mark_dirty_(px, py, px, py);
+  this->set_level_(px, py, level);
+}
 
+void IT8951ESensor::select_pixel_writer_() {
   if (this->buffer_ == nullptr) {
     return;
   }
-
-  if (x > this->max_x) {
-    this->max_x = x;
+  switch (this->rotation_) {
+    case display::DISPLAY_ROTATION_0_DEGREES:
+      this->pixel_writer_ = &IT8951ESensor::write_pixel_<display::DISPLAY_ROTATION_0_DEGREES>;
+      break;
+    case display::DISPLAY_ROTATION_90_DEGREES:
+      this->pixel_writer_ = &IT8951ESensor::write_pixel_<display::DISPLAY_ROTATION_90_DEGREES>;
+      break;
+    case display::DISPLAY_ROTATION_180_DEGREES:
+      this->pixel_writer_ = &IT8951ESensor::write_pixel_<display::DISPLAY_ROTATION_180_DEGREES>;
+      break;
+    case display::DISPLAY_ROTATION_270_DEGREES:
+      this->pixel_writer_ = &IT8951ESensor::write_pixel_<display::DISPLAY_ROTATION_270_DEGREES>;
+      break;
   }
+}
 
-  if (y > this->max_y) {
-    this->max_y = y;
+void HOT IT8951ESensor::draw_absolute_pixel_internal(int x, int y, Color color) {
+  if ((uint32_t) x >= this->panel_w_ || (uint32_t) y >= this->panel_h_ || this->buffer_ == nullptr) {
+    return;
   }
 
-  uint32_t internal_color = color.raw_32 & 0x0F;
-  uint16_t _bytewidth = this->get_width_internal() >> 1;
-  int32_t index = y * _bytewidth + (x >> 1);
+  this->mark_dirty_(x, y, x, y);
+  this->set_level_(x, y, this->color_to_level_(color));
+}
 
-  if (x & 0x1) {
-    this->buffer_[index] &= 0xF0;
-    this->buffer_[index] |= internal_color;
-  } else {
-    this->buffer_[index] &= 0x0F;
-    this->buffer_[index] |= internal_color << 4;
+void IT8951ESensor::fill(Color color) {
+  if (this->buffer_ == nullptr) {
+    return;
   }
+
+  uint8_t level = this->color_to_level_(color);
+  memset(this->buffer_, level << 4 | level, (this->panel_w_ * this->panel_h_) >> 1);
+  this->mark_dirty_(0, 0, this->panel_w_ - 1, this->panel_h_ - 1);
 }
 
 int IT8951ESensor::get_width_internal() {
-    if (this->device_info_ == nullptr) {
-        return M5EPD_PANEL_W; // workaround for touchscreen calling this reallly early
-    }
-    return this->device_info_->usPanelW;
+    // starts out as the M5Paper panel size, for the touchscreen calling this reallly early
+    return this->panel_w_;
 }
 
 int IT8951ESensor::get_height_internal() {
-    if (this->device_info_ == nullptr) {
-        return M5EPD_PANEL_H; // workaround for touchscreen calling this reallly early
-    }
-    return this->device_info_->usPanelH;
+    return this->panel_h_;
 }
 
 void IT8951ESensor::dump_config(){
@@ -390,6 +1278,18 @@ void IT8951ESensor::dump_config(){
         this->device_info_->usFWVersion,
         this->device_info_->usImgBufAddrL | (this->device_info_->usImgBufAddrH << 16)
     );
+    ESP_LOGCONFIG(TAG, "  Data Rate: %.2f MHz%s", this->get_data_rate() / 1e6f,
+                  this->data_rate_calibrated_ ? " (calibrated)" : "");
+    if (this->data_rate_calibrated_) {
+        ESP_LOGCONFIG(TAG, "  Max Data Rate: %.2f MHz", this->max_data_rate_ / 1e6f);
+    }
+    ESP_LOGCONFIG(TAG, "  Min Update Interval: %u ms", this->min_update_interval_);
+    ESP_LOGCONFIG(TAG, "  Page Cache Slots: %u", this->page_cache_size_);
+    ESP_LOGCONFIG(TAG, "  Gamma: %.2f", this->gamma_);
+    ESP_LOGCONFIG(TAG, "  Color On Is Ink: %s", YESNO(this->color_on_is_ink_));
+#ifdef USE_IT8951E_RENDER_TASK
+    ESP_LOGCONFIG(TAG, "  Render Task: %s", YESNO(this->render_task_ != nullptr));
+#endif
 }
 
 }  // namespace empty_spi_sensor
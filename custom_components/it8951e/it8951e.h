@@ -1,12 +1,77 @@
 #pragma once
 
+#include "esphome/core/automation.h"
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
 #include "esphome/components/spi/spi.h"
 #include "esphome/components/display/display_buffer.h"
+#include "compressed_frame.h"
+
+#ifdef USE_IT8951E_RENDER_TASK
+#include "spsc_queue.h"
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#endif
+
+#ifdef USE_IT8951E_TOUCH_FEEDBACK
+#include "esphome/components/touchscreen/touchscreen.h"
+#endif
 
 namespace esphome {
 namespace it8951e {
 
+#define M5EPD_PANEL_W 960
+#define M5EPD_PANEL_H 540
+
+/// A widget rectangle, in rotated display coordinates, that flashes when touched
+struct FeedbackArea {
+  int16_t x_min;
+  int16_t x_max;
+  int16_t y_min;
+  int16_t y_max;
+  display::DisplayPage *page;
+};
+
+/// A page rendered into its own frame in controller memory
+struct PageSlot {
+  display::DisplayPage *page;
+  uint32_t hash;
+  bool valid;
+};
+
+#ifdef USE_IT8951E_RENDER_TASK
+/// Upload and/or refresh of an area, handed from the main loop to the render task
+struct RenderJob {
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+  uint32_t addr;
+  uint8_t mode;
+  bool upload;
+  // touch feedback, the inverse of the feedback buffer goes out ahead of queued frames
+  bool feedback;
+};
+
+/// Reported back to the main loop when the render task finished a job
+struct RenderEvent {
+  uint32_t duration_ms;
+  // micros() when the upload and the waveform finished, 0 if the job had none
+  uint32_t upload_done_us;
+  uint32_t lut_done_us;
+  bool feedback;
+};
+#endif
+
+/// Steps of a frame reported to the stage callbacks, in order, consumers may rely on the values
+enum FrameStage : uint8_t {
+  FRAME_STAGE_UPDATE_START,
+  FRAME_STAGE_UPLOAD_DONE,
+  FRAME_STAGE_LUT_DONE,
+};
+
 class IT8951ESensor : public PollingComponent,
                       public display::DisplayBuffer,
                       public spi::SPIDevice<spi::BIT_ORDER_MSB_FIRST, spi::CLOCK_POLARITY_LOW, spi::CLOCK_PHASE_LEADING,
@@ -121,15 +186,56 @@ typedef enum               //             Typical
     this->cs_pin_ = cs; 
   }
   void set_reversed(bool reversed) { this->reversed_ = reversed; }
+  void set_min_update_interval(uint32_t min_update_interval) { this->min_update_interval_ = min_update_interval; }
+  void set_page_cache_size(uint8_t page_cache_size) { this->page_cache_size_ = page_cache_size; }
+  void set_gamma(float gamma) { this->gamma_ = gamma; }
+  void set_color_on_is_ink(bool color_on_is_ink) { this->color_on_is_ink_ = color_on_is_ink; }
+  void set_calibrate_data_rate(TemplatableValue<bool> calibrate) { this->calibrate_data_rate_ = calibrate; }
+  void set_max_data_rate(uint32_t max_data_rate) { this->max_data_rate_ = max_data_rate; }
+#ifdef USE_IT8951E_RENDER_TASK
+  void set_render_task(bool render_task) { this->use_render_task_ = render_task; }
+  void loop() override;
+#endif
+  /// Called with the time in ms it took to upload and refresh each frame
+  void add_on_frame_callback(std::function<void(uint32_t)> &&callback) {
+    this->frame_callback_.add(std::move(callback));
+  }
+  /// Called on the main loop with the micros() at which each stage of a frame happened
+  void add_on_stage_callback(std::function<void(FrameStage, uint32_t)> &&callback) {
+    this->stage_callback_.add(std::move(callback));
+    this->track_stages_ = true;
+  }
 
   void setup() override;
   void update() override;
+  /// Render and refresh right away, returns once the waveform has finished
+  void update_now();
   void dump_config() override;
-  display::DisplayType get_display_type() override { return display::DisplayType::DISPLAY_TYPE_BINARY; }
+  display::DisplayType get_display_type() override { return display::DisplayType::DISPLAY_TYPE_GRAYSCALE; }
 
   void clear(bool init);
+  void calibrate_data_rate();
+
+  void draw_gray_block(int x, int y, int w, int h, const uint8_t *gray, int stride);
+#ifdef USE_IT8951E_IMAGE_DECODER
+  bool draw_encoded_image(const uint8_t *data, size_t length, int x, int y);
+#endif
+
+  void fill(Color color) override;
+
+  void set_feedback_mode(uint8_t mode) { this->feedback_mode_ = mode; }
+  void add_feedback_area(int16_t x_min, int16_t x_max, int16_t y_min, int16_t y_max,
+                         display::DisplayPage *page = nullptr) {
+    this->feedback_areas_.push_back(FeedbackArea{x_min, x_max, y_min, y_max, page});
+  }
+  void save_screen(uint8_t slot);
+  void restore_screen(uint8_t slot);
+
+  void touch_feedback(uint16_t x, uint16_t y);
+  void touch_feedback_release() { this->feedback_active_ = false; }
 
  protected:
+  void draw_pixel_at(int x, int y, Color color) override;
   void draw_absolute_pixel_internal(int x, int y, Color color) override;
 
   int get_width_internal() override;
@@ -138,12 +244,33 @@ typedef enum               //             Typical
 
   uint32_t get_buffer_length_();
 
+  // rotation specialized pixel writers, picked at setup and again before every frame
+  uint32_t panel_w_{M5EPD_PANEL_W};
+  uint32_t panel_h_{M5EPD_PANEL_H};
+  uint32_t stride_{M5EPD_PANEL_W >> 1};
+  void (IT8951ESensor::*pixel_writer_)(int x, int y, uint8_t level){nullptr};
+
+  void select_pixel_writer_();
+  template<display::DisplayRotation ROTATION> void write_pixel_(int x, int y, uint8_t level);
+
+  uint8_t color_to_level_(Color color);
+  inline void set_level_(int x, int y, uint8_t level) {
+    uint8_t *pos = this->buffer_ + y * this->stride_ + (x >> 1);
+    if (x & 0x1) {
+      *pos = (*pos & 0xF0) | level;
+    } else {
+      *pos = (*pos & 0x0F) | (level << 4);
+    }
+  }
+
 
  private:
   IT8951DevInfo *device_info_{nullptr};
-  uint8_t *should_write_buffer_{nullptr};
   void get_device_info(IT8951DevInfo *info);
 
+  // dirty area drawn since the last write, inclusive
+  uint32_t min_x = UINT32_MAX;
+  uint32_t min_y = UINT32_MAX;
   uint32_t max_x = 0;
   uint32_t max_y = 0;
 
@@ -153,6 +280,103 @@ typedef enum               //             Typical
 
   bool reversed_ = false;
 
+  // luma to 4 bit ink level, built from gamma_ at setup
+  float gamma_{1.0f};
+  // bright colors draw ink, for lambdas written for monochrome displays
+  bool color_on_is_ink_{false};
+  uint8_t gray_lut_[256];
+#ifdef USE_SPI_DMA_BACKEND
+  // DMA capable copies of upload bands in wire order, one is packed while the other is on the wire
+  uint8_t *band_buffers_[2]{nullptr, nullptr};
+  uint8_t band_slot_{0};
+#endif
+
+  void build_gray_lut_();
+
+  // update coalescing, see schedule_update_()
+  uint32_t min_update_interval_{0};
+  uint32_t last_refresh_ms_{0};
+  bool update_pending_{false};
+  // bands and refreshes submitted to the bus or the render task that have not run yet
+  uint16_t uploads_in_flight_{0};
+  CallbackManager<void(uint32_t)> frame_callback_;
+  CallbackManager<void(FrameStage, uint32_t)> stage_callback_;
+  // only poll for the end of the waveform when someone listens for it
+  bool track_stages_{false};
+
+  void schedule_update_();
+  void flush_update_();
+  void render_frame_();
+  void wait_lut_done_();
+
+  // data rate probing at setup
+  // evaluated once in setup(), so a lambda can skip probing on a fast wake
+  TemplatableValue<bool> calibrate_data_rate_{false};
+  bool data_rate_calibrated_{false};
+  uint32_t max_data_rate_{40000000};
+
+  bool verify_data_rate_(uint32_t data_rate, uint32_t addr);
+  void write_memory_burst_(uint32_t addr, const uint16_t *data, uint16_t length);
+  void read_memory_burst_(uint32_t addr, uint16_t *data, uint16_t length);
+
+#ifdef USE_IT8951E_RENDER_TASK
+  // upload and LUT waits on the other core, the main loop only renders
+  bool use_render_task_{false};
+  TaskHandle_t render_task_{nullptr};
+  // copy of the frame buffer the render task uploads from
+  uint8_t *front_buffer_{nullptr};
+  SPSCQueue<RenderJob, 4> render_jobs_;
+  SPSCQueue<RenderEvent, 8> render_events_;
+  // touch feedback skips the frame queue, it is uploaded from its own copy of the widget
+  uint8_t *feedback_buffer_{nullptr};
+  SPSCQueue<RenderJob, 2> feedback_jobs_;
+  bool feedback_in_flight_{false};
+  // jobs handed to the task, and jobs whose upload and refresh command are out, the waveform may still run
+  uint16_t uploads_submitted_{0};
+  std::atomic<uint16_t> uploads_done_{0};
+  SemaphoreHandle_t upload_done_{nullptr};
+
+  static void render_task_loop_(void *param);
+  void run_render_job_(const RenderJob &job);
+  void run_feedback_jobs_();
+  void process_render_events_();
+#endif
+  void wait_render_idle_();
+  void yield_from_task_();
+
+  // touch feedback overlay
+  std::vector<FeedbackArea> feedback_areas_;
+  uint8_t feedback_mode_{UPDATE_MODE_DU};
+  bool feedback_active_{false};
+
+  // page cache in controller memory
+  std::vector<PageSlot> page_slots_;
+  uint8_t page_cache_size_{0};
+  uint32_t shown_slot_{0};
+  bool page_shown_{false};
+
+  void write_cached_page_();
+  static uint32_t fnv1_hash_(const uint8_t *data, uint32_t length);
+  static bool needs_gc16_(const uint8_t *line, uint32_t length);
+  m5epd_update_mode_t frame_mode_(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  uint32_t image_buffer_addr_() {
+    return this->device_info_->usImgBufAddrL | (this->device_info_->usImgBufAddrH << 16);
+  }
+
+  // compressed off-screen surfaces in external RAM
+  std::vector<CompressedFrame> surfaces_;
+
+  void refresh_image_area_(int x, int y, int w, int h);
+#ifdef USE_IT8951E_IMAGE_DECODER
+  bool decode_jpeg_(const uint8_t *data, size_t length, int x, int y);
+  bool decode_png_(const uint8_t *data, size_t length, int x, int y);
+#endif
+
+  void rotate_point_(int &x, int &y);
+  void to_absolute_area_(int x1, int y1, int x2, int y2, uint32_t &x_min, uint32_t &y_min, uint32_t &x_max,
+                         uint32_t &y_max);
+  void mark_dirty_(uint32_t x_min, uint32_t y_min, uint32_t x_max, uint32_t y_max);
+
   void enable_cs();
   void disable_cs();
 
@@ -160,6 +384,7 @@ typedef enum               //             Typical
 
   void wait_busy(uint32_t timeout = 3000);
   void check_busy(uint32_t timeout = 3000);
+  bool is_lut_busy_();
 
   // comes from ref driver code from waveshare
   uint16_t read_word();
@@ -170,23 +395,84 @@ typedef enum               //             Typical
   void write_word(uint16_t cmd);
   void write_reg(uint16_t addr, uint16_t data);
   void set_target_memory_addr(uint32_t tar_addr);
-  void write_args(uint16_t cmd, uint16_t *args, uint16_t length);
+  void write_args(uint16_t cmd, const uint16_t *args, uint16_t length);
+  void begin_data_burst_();
 
   void set_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
   void update_area(uint16_t x, uint16_t y, uint16_t w,
-                    uint16_t h, m5epd_update_mode_t mode);
+                    uint16_t h, m5epd_update_mode_t mode, uint32_t addr);
 
 
 
   void write_buffer_to_display(uint16_t x, uint16_t y, uint16_t w,
-                                uint16_t h, const uint8_t *gram);
+                                uint16_t h, const uint8_t *gram, uint32_t addr, bool invert = false);
+  void begin_image_load_(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t addr);
+  void write_packed_row_(const uint8_t *line, uint16_t length, bool invert);
+  void end_image_load_();
+  void write_band_(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t *gram, uint32_t addr, bool invert,
+                   std::function<void()> &&done);
+  void upload_area_(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint32_t addr, m5epd_update_mode_t mode,
+                    bool upload = true);
   void write_display();
 };
 
+#ifdef USE_IT8951E_TOUCH_FEEDBACK
+class TouchFeedbackListener : public touchscreen::TouchListener {
+ public:
+  TouchFeedbackListener(IT8951ESensor *parent) : parent_(parent) {}
+
+  void touch(touchscreen::TouchPoint tp) override { this->parent_->touch_feedback(tp.x, tp.y); }
+  void release() override { this->parent_->touch_feedback_release(); }
+
+ protected:
+  IT8951ESensor *parent_;
+};
+#endif
+
 template<typename... Ts> class ClearAction : public Action<Ts...>, public Parented<IT8951ESensor> {
  public:
   void play(Ts... x) override { this->parent_->clear(true); }
 };
 
+template<typename... Ts> class UpdateNowAction : public Action<Ts...>, public Parented<IT8951ESensor> {
+ public:
+  void play(Ts... x) override { this->parent_->update_now(); }
+};
+
+template<typename... Ts> class SaveScreenAction : public Action<Ts...>, public Parented<IT8951ESensor> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, slot)
+
+  void play(Ts... x) override { this->parent_->save_screen(this->slot_.value(x...)); }
+};
+
+template<typename... Ts> class RestoreScreenAction : public Action<Ts...>, public Parented<IT8951ESensor> {
+ public:
+  TEMPLATABLE_VALUE(uint8_t, slot)
+
+  void play(Ts... x) override { this->parent_->restore_screen(this->slot_.value(x...)); }
+};
+
+#ifdef USE_IT8951E_IMAGE_DECODER
+template<typename... Ts> class DrawImageAction : public Action<Ts...>, public Parented<IT8951ESensor> {
+ public:
+  TEMPLATABLE_VALUE(int, x)
+  TEMPLATABLE_VALUE(int, y)
+
+  void set_data(const uint8_t *data, size_t length) {
+    this->data_ = data;
+    this->length_ = length;
+  }
+
+  void play(Ts... x) override {
+    this->parent_->draw_encoded_image(this->data_, this->length_, this->x_.value(x...), this->y_.value(x...));
+  }
+
+ protected:
+  const uint8_t *data_{nullptr};
+  size_t length_{0};
+};
+#endif
+
 }  // namespace empty_spi_sensor
 }  // namespace esphome
\ No newline at end of file
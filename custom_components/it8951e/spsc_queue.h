@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace esphome {
+namespace it8951e {
+
+/** Lock-free queue between exactly one producer and one consumer task.
+ *
+ * The producer only writes head_, the consumer only writes tail_, so a
+ * push and a pop can run at the same time on different cores. Holds at
+ * most N - 1 items.
+ */
+template<typename T, size_t N> class SPSCQueue {
+ public:
+  /// Add an item, false if the queue is full. Producer only.
+  bool push(const T &item) {
+    size_t head = this->head_.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % N;
+    if (next == this->tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    this->items_[head] = item;
+    this->head_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /// Take the oldest item, false if the queue is empty. Consumer only.
+  bool pop(T &item) {
+    size_t tail = this->tail_.load(std::memory_order_relaxed);
+    if (tail == this->head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = this->items_[tail];
+    this->tail_.store((tail + 1) % N, std::memory_order_release);
+    return true;
+  }
+
+ protected:
+  T items_[N];
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+};
+
+}  // namespace it8951e
+}  // namespace esphome
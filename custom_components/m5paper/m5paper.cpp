@@ -15,9 +15,9 @@ namespace m5paper {
 static const char *TAG = "m5paper.component";
 
 void M5PaperComponent::setup() {
-    ESP_LOGE(TAG, "m5paper starting up!");
     this->main_power_pin_->pin_mode(gpio::FLAG_OUTPUT);
     this->main_power_pin_->digital_write(true);
+    ESP_LOGD(TAG, "m5paper starting up!");
 
     this->battery_power_pin_->pin_mode(gpio::FLAG_OUTPUT);
     this->battery_power_pin_->digital_write(true);
@@ -19,6 +19,8 @@ class M5PaperComponent : public PollingComponent {
     void dump_config() override;
 
     public:
+        // the main power latch has to be held before anything else takes its time
+        float get_setup_priority() const override { return setup_priority::BUS + 100.0f; }
         void set_battery_power_pin(GPIOPin *power) { this->battery_power_pin_ = power; }
         void set_main_power_pin(GPIOPin *power) { this->main_power_pin_ = power; }
         void set_battery_voltage(sensor::Sensor *battery_voltage) { battery_voltage_ = battery_voltage; }
@@ -18,6 +18,10 @@ SPIComponent = spi_ns.class_("SPIComponent", cg.Component)
 SPIDevice = spi_ns.class_("SPIDevice")
 MULTI_CONF = True
 
+CONF_USE_DMA = "use_dma"
+CONF_TRANSACTION_QUEUE = "transaction_queue"
+CONF_SPI_PRIORITY = "spi_priority"
+
 CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
@@ -25,6 +29,8 @@ CONFIG_SCHEMA = cv.All(
             cv.Required(CONF_CLK_PIN): pins.gpio_output_pin_schema,
             cv.Optional(CONF_MISO_PIN): pins.gpio_input_pin_schema,
             cv.Optional(CONF_MOSI_PIN): pins.gpio_output_pin_schema,
+            cv.Optional(CONF_USE_DMA, default=False): cv.All(cv.boolean, cv.only_on_esp32),
+            cv.Optional(CONF_TRANSACTION_QUEUE, default=False): cv.boolean,
         }
     ),
     cv.has_at_least_one_key(CONF_MISO_PIN, CONF_MOSI_PIN),
@@ -45,8 +51,11 @@ async def to_code(config):
     if CONF_MOSI_PIN in config:
         mosi = await cg.gpio_pin_expression(config[CONF_MOSI_PIN])
         cg.add(var.set_mosi(mosi))
+    cg.add(var.set_transaction_queue(config[CONF_TRANSACTION_QUEUE]))
 
-    if CORE.is_esp32 and CORE.using_arduino:
+    if config[CONF_USE_DMA]:
+        cg.add_define("USE_SPI_DMA_BACKEND")
+    elif CORE.is_esp32 and CORE.using_arduino:
         cg.add_library("SPI", None)
     if CORE.is_esp8266:
         cg.add_library("SPI", None)
@@ -59,6 +68,7 @@ def spi_device_schema(cs_pin_required=True):
     """
     schema = {
         cv.GenerateID(CONF_SPI_ID): cv.use_id(SPIComponent),
+        cv.Optional(CONF_SPI_PRIORITY, default=0): cv.uint8_t,
     }
     if cs_pin_required:
         schema[cv.Required(CONF_CS_PIN)] = pins.gpio_output_pin_schema
@@ -70,6 +80,7 @@ def spi_device_schema(cs_pin_required=True):
 async def register_spi_device(var, config):
     parent = await cg.get_variable(config[CONF_SPI_ID])
     cg.add(var.set_spi_parent(parent))
+    cg.add(var.set_spi_priority(config[CONF_SPI_PRIORITY]))
     if CONF_CS_PIN in config:
         pin = await cg.gpio_pin_expression(config[CONF_CS_PIN])
         cg.add(var.set_cs_pin(pin))
@@ -0,0 +1,104 @@
+import esphome.codegen as cg
+import esphome.config_validation as cv
+from esphome.components import sensor
+from esphome.const import (
+    CONF_ID,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
+    UNIT_PERCENT,
+)
+from . import spi_ns, SPIDevice
+
+DEPENDENCIES = ["spi"]
+
+CONF_SPI_DEVICE_ID = "spi_device_id"
+CONF_BYTES_WRITTEN = "bytes_written"
+CONF_BYTES_READ = "bytes_read"
+CONF_QUEUED_TRANSACTIONS = "queued_transactions"
+CONF_ENABLES = "enables"
+CONF_BUS_TIME = "bus_time"
+CONF_BUS_UTILIZATION = "bus_utilization"
+CONF_QUEUE_DEPTH = "queue_depth"
+CONF_QUEUE_WAIT = "queue_wait"
+CONF_BUS_WAIT = "bus_wait"
+
+UNIT_BYTES = "B"
+
+SPIStatsSensor = spi_ns.class_("SPIStatsSensor", cg.PollingComponent)
+
+CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(SPIStatsSensor),
+        cv.Required(CONF_SPI_DEVICE_ID): cv.use_id(SPIDevice),
+        cv.Optional(CONF_BYTES_WRITTEN): sensor.sensor_schema(
+            unit_of_measurement=UNIT_BYTES,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_BYTES_READ): sensor.sensor_schema(
+            unit_of_measurement=UNIT_BYTES,
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_QUEUED_TRANSACTIONS): sensor.sensor_schema(
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_ENABLES): sensor.sensor_schema(
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_BUS_TIME): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_TOTAL_INCREASING,
+        ),
+        cv.Optional(CONF_BUS_UTILIZATION): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            accuracy_decimals=2,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_QUEUE_DEPTH): sensor.sensor_schema(
+            accuracy_decimals=0,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_QUEUE_WAIT): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            accuracy_decimals=2,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+        cv.Optional(CONF_BUS_WAIT): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            accuracy_decimals=2,
+            state_class=STATE_CLASS_MEASUREMENT,
+        ),
+    }
+).extend(cv.polling_component_schema("60s"))
+
+SENSORS = {
+    CONF_BYTES_WRITTEN: "set_bytes_written_sensor",
+    CONF_BYTES_READ: "set_bytes_read_sensor",
+    CONF_QUEUED_TRANSACTIONS: "set_queued_transactions_sensor",
+    CONF_ENABLES: "set_enables_sensor",
+    CONF_BUS_TIME: "set_bus_time_sensor",
+    CONF_BUS_UTILIZATION: "set_bus_utilization_sensor",
+    CONF_QUEUE_DEPTH: "set_queue_depth_sensor",
+    CONF_QUEUE_WAIT: "set_queue_wait_sensor",
+    CONF_BUS_WAIT: "set_bus_wait_sensor",
+}
+
+
+async def to_code(config):
+    cg.add_define("USE_SPI_STATS")
+    var = cg.new_Pvariable(config[CONF_ID])
+    await cg.register_component(var, config)
+
+    device = await cg.get_variable(config[CONF_SPI_DEVICE_ID])
+    cg.add(var.set_stats(device.get_spi_stats()))
+    cg.add(var.set_queue_stats(device.get_queue_stats()))
+
+    for key, setter in SENSORS.items():
+        if key in config:
+            sens = await sensor.new_sensor(config[key])
+            cg.add(getattr(var, setter)(sens))
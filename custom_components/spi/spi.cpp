@@ -3,24 +3,88 @@
 #include "esphome/core/helpers.h"
 #include "esphome/core/application.h"
 
+#ifdef USE_SPI_DMA_BACKEND
+#include <esp_heap_caps.h>
+#include <soc/soc_memory_layout.h>
+#endif
+
+#ifdef USE_SPI_FAST_GPIO
+#include <soc/gpio_reg.h>
+#include <soc/soc_caps.h>
+#endif
+
 namespace esphome {
 namespace spi {
 
 static const char *const TAG = "spi";
 
+// longest time loop() keeps running queued transactions before giving the main loop back
+static const uint32_t QUEUE_BUDGET_MS = 10;
+
+#ifdef USE_SPI_DMA_BACKEND
+// size of each bounce buffer, and of the chunks copied into them
+static const size_t DMA_BUFFER_SIZE = 4096;
+// largest single transaction, used for asynchronous writes straight from DMA capable memory
+static const size_t DMA_MAX_TRANSFER = 32768;
+// writes up to this size are sent in polling mode, queueing costs more than it saves
+static const size_t DMA_POLLING_MAX = 64;
+#endif  // USE_SPI_DMA_BACKEND
+
+#ifdef USE_SPI_FAST_GPIO
+/// Look up the set/clear/input registers of an internal pin, false if it can't be driven directly.
+static bool fast_gpio_for_pin(GPIOPin *pin, FastGPIO *fast) {
+  if (pin == nullptr) {
+    return true;
+  }
+  if (!pin->is_internal() || ((InternalGPIOPin *) pin)->is_inverted()) {
+    return false;
+  }
+  uint8_t num = ((InternalGPIOPin *) pin)->get_pin();
+  if (num < 32) {
+    fast->set_reg = (volatile uint32_t *) GPIO_OUT_W1TS_REG;
+    fast->clear_reg = (volatile uint32_t *) GPIO_OUT_W1TC_REG;
+    fast->in_reg = (const volatile uint32_t *) GPIO_IN_REG;
+    fast->mask = 1UL << num;
+    return true;
+  }
+#if SOC_GPIO_PIN_COUNT > 32
+  fast->set_reg = (volatile uint32_t *) GPIO_OUT1_W1TS_REG;
+  fast->clear_reg = (volatile uint32_t *) GPIO_OUT1_W1TC_REG;
+  fast->in_reg = (const volatile uint32_t *) GPIO_IN1_REG;
+  fast->mask = 1UL << (num - 32);
+  return true;
+#else
+  return false;
+#endif
+}
+#endif  // USE_SPI_FAST_GPIO
+
 void IRAM_ATTR HOT SPIComponent::disable() {
 #ifdef USE_SPI_ARDUINO_BACKEND
   if (this->hw_spi_ != nullptr) {
     this->hw_spi_->endTransaction();
   }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+  if (this->dma_device_ != nullptr) {
+    this->dma_wait_();
+  }
+#endif  // USE_SPI_DMA_BACKEND
   if (this->active_cs_) {
     this->active_cs_->digital_write(true);
     this->active_cs_ = nullptr;
   }
+#ifdef USE_ESP32
+  if (this->bus_lock_ != nullptr) {
+    xSemaphoreGiveRecursive(this->bus_lock_);
+  }
+#endif  // USE_ESP32
 }
 void SPIComponent::setup() {
   ESP_LOGCONFIG(TAG, "Setting up SPI bus...");
+#ifdef USE_ESP32
+  this->bus_lock_ = xSemaphoreCreateRecursiveMutex();
+#endif  // USE_ESP32
   this->clk_->setup();
   this->clk_->digital_write(true);
 
@@ -85,6 +149,42 @@ void SPIComponent::setup() {
 #endif  // USE_ESP32
 #endif  // USE_SPI_ARDUINO_BACKEND
 
+#ifdef USE_SPI_DMA_BACKEND
+  bool use_dma = this->clk_->is_internal() && !((InternalGPIOPin *) this->clk_)->is_inverted();
+  if (this->miso_ != nullptr && (!this->miso_->is_internal() || ((InternalGPIOPin *) this->miso_)->is_inverted()))
+    use_dma = false;
+  if (this->mosi_ != nullptr && (!this->mosi_->is_internal() || ((InternalGPIOPin *) this->mosi_)->is_inverted()))
+    use_dma = false;
+
+  if (use_dma) {
+    spi_bus_config_t bus_config{};
+    bus_config.sclk_io_num = ((InternalGPIOPin *) this->clk_)->get_pin();
+    bus_config.miso_io_num = this->miso_ != nullptr ? ((InternalGPIOPin *) this->miso_)->get_pin() : -1;
+    bus_config.mosi_io_num = this->mosi_ != nullptr ? ((InternalGPIOPin *) this->mosi_)->get_pin() : -1;
+    bus_config.quadwp_io_num = -1;
+    bus_config.quadhd_io_num = -1;
+    bus_config.max_transfer_sz = DMA_MAX_TRANSFER;
+
+    esp_err_t err = spi_bus_initialize(SPI2_HOST, &bus_config, SPI_DMA_CH_AUTO);
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "Could not initialize the DMA SPI bus: %s", esp_err_to_name(err));
+      this->mark_failed();
+      return;
+    }
+
+    for (auto &buffer : this->dma_buffers_) {
+      buffer = (uint8_t *) heap_caps_malloc(DMA_BUFFER_SIZE, MALLOC_CAP_DMA);
+      if (buffer == nullptr) {
+        ESP_LOGE(TAG, "Could not allocate DMA buffers");
+        this->mark_failed();
+        return;
+      }
+    }
+    return;
+  }
+  ESP_LOGW(TAG, "DMA needs internal, non inverted pins, falling back to software SPI");
+#endif  // USE_SPI_DMA_BACKEND
+
   if (this->miso_ != nullptr) {
     this->miso_->setup();
   }
@@ -92,6 +192,12 @@ void SPIComponent::setup() {
     this->mosi_->setup();
     this->mosi_->digital_write(false);
   }
+
+#ifdef USE_SPI_FAST_GPIO
+  this->fast_gpio_ = fast_gpio_for_pin(this->clk_, &this->fast_clk_) &&
+                     fast_gpio_for_pin(this->miso_, &this->fast_miso_) &&
+                     fast_gpio_for_pin(this->mosi_, &this->fast_mosi_);
+#endif  // USE_SPI_FAST_GPIO
 }
 void SPIComponent::dump_config() {
   ESP_LOGCONFIG(TAG, "SPI bus:");
@@ -101,9 +207,291 @@ void SPIComponent::dump_config() {
 #ifdef USE_SPI_ARDUINO_BACKEND
   ESP_LOGCONFIG(TAG, "  Using HW SPI: %s", YESNO(this->hw_spi_ != nullptr));
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+  ESP_LOGCONFIG(TAG, "  Using DMA: %s", YESNO(this->dma_buffers_[0] != nullptr));
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+  ESP_LOGCONFIG(TAG, "  Using fast GPIO: %s", YESNO(this->fast_gpio_));
+#endif  // USE_SPI_FAST_GPIO
+  ESP_LOGCONFIG(TAG, "  Transaction queue: %s", YESNO(this->transaction_queue_));
 }
 float SPIComponent::get_setup_priority() const { return setup_priority::BUS; }
 
+void SPIComponent::submit(uint8_t priority, SPIQueueStats *stats, std::function<void()> &&transaction) {
+  stats->transactions++;
+  if (!this->transaction_queue_) {
+    transaction();
+    return;
+  }
+
+  stats->depth++;
+  stats->max_depth = std::max(stats->max_depth, stats->depth);
+  this->queue_.push_back(SPITransaction{priority, this->queue_sequence_++, micros(), stats, std::move(transaction)});
+  this->high_freq_.start();
+}
+
+void SPIComponent::loop() {
+#ifdef USE_SPI_DMA_BACKEND
+  if (!this->dma_loop_()) {
+    // an asynchronous write still holds the bus, the queue waits behind it and the main loop goes on
+    return;
+  }
+#endif  // USE_SPI_DMA_BACKEND
+  uint32_t start = millis();
+  while (!this->queue_.empty() && millis() - start < QUEUE_BUDGET_MS) {
+    auto next = std::max_element(this->queue_.begin(), this->queue_.end(),
+                                 [](const SPITransaction &a, const SPITransaction &b) {
+                                   if (a.priority != b.priority)
+                                     return a.priority < b.priority;
+                                   return a.sequence > b.sequence;
+                                 });
+    SPITransaction transaction = std::move(*next);
+    this->queue_.erase(next);
+
+    SPIQueueStats *stats = transaction.stats;
+    stats->depth--;
+    stats->last_wait_us = micros() - transaction.queued_us;
+    stats->max_wait_us = std::max(stats->max_wait_us, stats->last_wait_us);
+    stats->total_wait_us += stats->last_wait_us;
+
+    // the transaction may submit follow-up transactions
+    transaction.run();
+  }
+  if (this->queue_.empty()) {
+    this->high_freq_.stop();
+  }
+}
+
+void SPIComponent::flush_queue() {
+  while (!this->queue_.empty()) {
+    this->loop();
+    App.feed_wdt();
+  }
+  this->wait_async_write();
+}
+
+void SPIComponent::wait_async_write() {
+#ifdef USE_SPI_DMA_BACKEND
+  // whoever started the write holds the bus until its callback ran
+  if (this->bus_lock_ != nullptr) {
+    xSemaphoreTakeRecursive(this->bus_lock_, portMAX_DELAY);
+  }
+  this->dma_wait_();
+  if (this->bus_lock_ != nullptr) {
+    xSemaphoreGiveRecursive(this->bus_lock_);
+  }
+#endif  // USE_SPI_DMA_BACKEND
+}
+
+#ifdef USE_SPI_DMA_BACKEND
+/// Keep an asynchronous write of the main loop going, true once nothing is left on the wire
+bool SPIComponent::dma_loop_() {
+  if (this->bus_lock_ == nullptr || xSemaphoreTakeRecursive(this->bus_lock_, 0) != pdTRUE) {
+    // another task has the bus, it finishes its own writes
+    return true;
+  }
+  if (this->async_active_) {
+    // collect whatever has finished without blocking, then keep the queue full
+    while (this->dma_in_flight_ > 0) {
+      uint8_t in_flight = this->dma_in_flight_;
+      this->dma_collect_(false);
+      if (in_flight == this->dma_in_flight_)
+        break;
+    }
+    this->dma_refill_();
+    if (this->async_remaining_ == 0 && this->dma_in_flight_ == 0) {
+      this->dma_wait_();
+    }
+  }
+  bool idle = !this->async_active_;
+  xSemaphoreGiveRecursive(this->bus_lock_);
+  return idle;
+}
+
+bool SPIComponent::dma_write_async_(const uint8_t *data, size_t length, std::function<void()> &callback) {
+  if (this->dma_device_ == nullptr || !esp_ptr_dma_capable(data)) {
+    return false;
+  }
+
+  this->dma_wait_();
+  this->async_data_ = data;
+  this->async_remaining_ = length;
+  this->async_callback_ = std::move(callback);
+  this->async_active_ = true;
+  this->dma_refill_();
+  return true;
+}
+
+/// Queue the next chunks of the asynchronous write, two are on the wire at most
+void SPIComponent::dma_refill_() {
+  while (this->async_remaining_ > 0 && this->dma_in_flight_ < 2) {
+    size_t chunk = std::min(this->async_remaining_, DMA_MAX_TRANSFER);
+    this->dma_queue_(this->dma_next_slot_, this->async_data_, chunk);
+    this->async_data_ += chunk;
+    this->async_remaining_ -= chunk;
+  }
+}
+
+void SPIComponent::dma_configure_(uint8_t mode, uint32_t clock, bool lsb_first) {
+  if (this->dma_device_ != nullptr && this->dma_mode_ == mode && this->dma_clock_ == clock &&
+      this->dma_lsb_first_ == lsb_first) {
+    return;
+  }
+
+  if (this->dma_device_ != nullptr) {
+    this->dma_wait_();
+    spi_bus_remove_device(this->dma_device_);
+    this->dma_device_ = nullptr;
+  }
+
+  spi_device_interface_config_t device_config{};
+  device_config.mode = mode;
+  device_config.clock_speed_hz = clock;
+  // chip select stays under control of the devices
+  device_config.spics_io_num = -1;
+  device_config.queue_size = 2;
+  device_config.flags = SPI_DEVICE_NO_DUMMY;
+  if (lsb_first) {
+    device_config.flags |= SPI_DEVICE_TXBIT_LSBFIRST | SPI_DEVICE_RXBIT_LSBFIRST;
+  }
+
+  esp_err_t err = spi_bus_add_device(SPI2_HOST, &device_config, &this->dma_device_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Could not configure the DMA SPI device: %s", esp_err_to_name(err));
+    this->dma_device_ = nullptr;
+    return;
+  }
+  this->dma_mode_ = mode;
+  this->dma_clock_ = clock;
+  this->dma_lsb_first_ = lsb_first;
+}
+
+uint8_t SPIComponent::dma_transfer_byte_(uint8_t data) {
+  this->dma_wait_();
+
+  spi_transaction_t transaction{};
+  transaction.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+  transaction.length = 8;
+  transaction.tx_data[0] = data;
+  spi_device_polling_transmit(this->dma_device_, &transaction);
+  return transaction.rx_data[0];
+}
+
+void SPIComponent::dma_transfer_(uint8_t *data, size_t length) {
+  this->dma_wait_();
+
+  while (length > 0) {
+    size_t chunk = std::min(length, DMA_BUFFER_SIZE);
+    memcpy(this->dma_buffers_[0], data, chunk);
+
+    spi_transaction_t transaction{};
+    transaction.length = chunk * 8;
+    transaction.tx_buffer = this->dma_buffers_[0];
+    transaction.rx_buffer = this->dma_buffers_[1];
+    spi_device_polling_transmit(this->dma_device_, &transaction);
+
+    memcpy(data, this->dma_buffers_[1], chunk);
+    data += chunk;
+    length -= chunk;
+  }
+}
+
+/** Write a buffer through the bounce buffers.
+ *
+ * While one bounce buffer is on the wire the next chunk is copied into the other one, optionally swapping
+ * every pair of bytes to send 16 bit words most significant byte first. Returns once everything is sent.
+ */
+void SPIComponent::dma_write_(const uint8_t *data, size_t length, bool swap16) {
+  this->dma_wait_();
+
+  if (length <= DMA_POLLING_MAX) {
+    spi_transaction_t transaction{};
+    transaction.length = length * 8;
+    uint8_t *out = this->dma_buffers_[0];
+    if (length <= 4) {
+      transaction.flags = SPI_TRANS_USE_TXDATA;
+      out = transaction.tx_data;
+    } else {
+      transaction.tx_buffer = out;
+    }
+    if (swap16) {
+      for (size_t i = 0; i + 1 < length; i += 2) {
+        out[i] = data[i + 1];
+        out[i + 1] = data[i];
+      }
+    } else {
+      memcpy(out, data, length);
+    }
+    spi_device_polling_transmit(this->dma_device_, &transaction);
+    return;
+  }
+
+  size_t offset = 0;
+  while (offset < length) {
+    size_t chunk = std::min(length - offset, DMA_BUFFER_SIZE);
+    if (this->dma_in_flight_ == 2) {
+      this->dma_collect_(true);
+    }
+
+    uint8_t *buffer = this->dma_buffers_[this->dma_next_slot_];
+    if (swap16) {
+      for (size_t i = 0; i + 1 < chunk; i += 2) {
+        buffer[i] = data[offset + i + 1];
+        buffer[i + 1] = data[offset + i];
+      }
+    } else {
+      memcpy(buffer, data + offset, chunk);
+    }
+    this->dma_queue_(this->dma_next_slot_, buffer, chunk);
+    offset += chunk;
+  }
+
+  while (this->dma_in_flight_ > 0) {
+    this->dma_collect_(true);
+  }
+}
+
+void SPIComponent::dma_queue_(uint8_t slot, const uint8_t *data, size_t length) {
+  spi_transaction_t &transaction = this->dma_transactions_[slot];
+  transaction = {};
+  transaction.length = length * 8;
+  transaction.tx_buffer = data;
+  spi_device_queue_trans(this->dma_device_, &transaction, portMAX_DELAY);
+  this->dma_in_flight_++;
+  this->dma_next_slot_ = slot ^ 1;
+}
+
+/// Collect the oldest queued transaction, results come back in queue order
+void SPIComponent::dma_collect_(bool block) {
+  if (this->dma_in_flight_ == 0) {
+    return;
+  }
+  spi_transaction_t *result;
+  if (spi_device_get_trans_result(this->dma_device_, &result, block ? portMAX_DELAY : 0) == ESP_OK) {
+    this->dma_in_flight_--;
+  }
+}
+
+/** Block until the queue is empty, including an asynchronous write.
+ *
+ * The callback of the write runs here, before the bus is used for anything else. It may write itself.
+ */
+void SPIComponent::dma_wait_() {
+  while (this->async_remaining_ > 0 || this->dma_in_flight_ > 0) {
+    this->dma_collect_(true);
+    this->dma_refill_();
+  }
+  if (this->async_active_) {
+    this->async_active_ = false;
+    auto callback = std::move(this->async_callback_);
+    this->async_callback_ = nullptr;
+    if (callback) {
+      callback();
+    }
+  }
+}
+#endif  // USE_SPI_DMA_BACKEND
+
 void SPIComponent::cycle_clock_(bool value) {
   uint32_t start = arch_get_cpu_cycle_count();
   while (start - arch_get_cpu_cycle_count() < this->wait_cycle_)
@@ -235,5 +623,127 @@ template uint8_t SPIComponent::transfer_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIG
 template uint8_t SPIComponent::transfer_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, true, true>(
     uint8_t data);
 
+#ifdef USE_SPI_FAST_GPIO
+/// Busy wait until cycles have passed since start, returns the cycle count to time the next edge from.
+static inline uint32_t ALWAYS_INLINE wait_half_period(uint32_t start, uint32_t cycles) {
+  uint32_t now;
+  while ((now = arch_get_cpu_cycle_count()) - start < cycles)
+    ;
+  return now;
+}
+
+template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, bool READ, bool WRITE>
+void HOT SPIComponent::transfer_fast_(const uint8_t *write_data, uint8_t *read_data, size_t length) {
+  // keep everything in registers for the whole block
+  volatile uint32_t *const clk_idle = CLOCK_POLARITY ? this->fast_clk_.set_reg : this->fast_clk_.clear_reg;
+  volatile uint32_t *const clk_active = CLOCK_POLARITY ? this->fast_clk_.clear_reg : this->fast_clk_.set_reg;
+  const uint32_t clk_mask = this->fast_clk_.mask;
+  volatile uint32_t *const mosi_set = this->fast_mosi_.set_reg;
+  volatile uint32_t *const mosi_clear = this->fast_mosi_.clear_reg;
+  const uint32_t mosi_mask = this->fast_mosi_.mask;
+  const volatile uint32_t *const miso_in = this->fast_miso_.in_reg;
+  const uint32_t miso_mask = this->fast_miso_.mask;
+  const uint32_t wait = this->wait_cycle_;
+
+  // Clock starts out at idle level
+  *clk_idle = clk_mask;
+  uint32_t edge = wait != 0 ? arch_get_cpu_cycle_count() : 0;
+
+  for (size_t n = 0; n < length; n++) {
+    uint8_t data = WRITE ? write_data[n] : 0;
+    uint8_t out_data = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+      uint8_t shift = BIT_ORDER == BIT_ORDER_MSB_FIRST ? 7 - i : i;
+
+      if (CLOCK_PHASE == CLOCK_PHASE_LEADING) {
+        if (WRITE) {
+          *((data >> shift) & 1 ? mosi_set : mosi_clear) = mosi_mask;
+        }
+        if (wait != 0)
+          edge = wait_half_period(edge, wait);
+        *clk_active = clk_mask;
+        if (READ) {
+          out_data |= uint8_t((*miso_in & miso_mask) != 0) << shift;
+        }
+        if (wait != 0)
+          edge = wait_half_period(edge, wait);
+        *clk_idle = clk_mask;
+      } else {
+        if (wait != 0)
+          edge = wait_half_period(edge, wait);
+        *clk_active = clk_mask;
+        if (WRITE) {
+          *((data >> shift) & 1 ? mosi_set : mosi_clear) = mosi_mask;
+        }
+        if (wait != 0)
+          edge = wait_half_period(edge, wait);
+        *clk_idle = clk_mask;
+        if (READ) {
+          out_data |= uint8_t((*miso_in & miso_mask) != 0) << shift;
+        }
+      }
+    }
+
+    if (READ) {
+      read_data[n] = out_data;
+    }
+  }
+
+  App.feed_wdt();
+}
+
+// Generated the same way as the transfer_ instantiations above
+
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_LEADING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_LEADING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_LEADING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_TRAILING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_TRAILING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_TRAILING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_LEADING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_LEADING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_LEADING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_LSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_LEADING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_LEADING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_LEADING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_TRAILING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_TRAILING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_LOW, CLOCK_PHASE_TRAILING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_LEADING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_LEADING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_LEADING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, false, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, true, false>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+template void SPIComponent::transfer_fast_<BIT_ORDER_MSB_FIRST, CLOCK_POLARITY_HIGH, CLOCK_PHASE_TRAILING, true, true>(
+    const uint8_t *write_data, uint8_t *read_data, size_t length);
+#endif  // USE_SPI_FAST_GPIO
+
 }  // namespace spi
 }  // namespace esphome
@@ -1,10 +1,16 @@
 #pragma once
 
 #include "esphome/core/component.h"
+#include "esphome/core/defines.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
 #include <vector>
 
-#ifdef USE_ARDUINO
+#if defined(USE_ARDUINO) && !defined(USE_SPI_DMA_BACKEND)
 #define USE_SPI_ARDUINO_BACKEND
 #endif
 
@@ -12,6 +18,16 @@
 #include <SPI.h>
 #endif
 
+#ifdef USE_SPI_DMA_BACKEND
+#include <driver/spi_master.h>
+#endif
+
+#ifdef USE_ESP32
+#define USE_SPI_FAST_GPIO
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#endif
+
 namespace esphome {
 namespace spi {
 
@@ -69,11 +85,80 @@ enum SPIDataRate : uint32_t {
   DATA_RATE_40MHZ = 40000000,
 };
 
+#ifdef USE_SPI_FAST_GPIO
+/// Direct register access to one GPIO, bypassing the GPIOPin virtual calls.
+struct FastGPIO {
+  volatile uint32_t *set_reg{nullptr};
+  volatile uint32_t *clear_reg{nullptr};
+  const volatile uint32_t *in_reg{nullptr};
+  uint32_t mask{0};
+};
+#endif  // USE_SPI_FAST_GPIO
+
+/// Queue statistics of one SPI device, wait times are from submit() until the transaction starts.
+struct SPIQueueStats {
+  uint16_t depth{0};
+  uint16_t max_depth{0};
+  /// transactions passed to submit(), only those wait in the queue
+  uint32_t transactions{0};
+  uint32_t last_wait_us{0};
+  uint32_t max_wait_us{0};
+  uint64_t total_wait_us{0};
+
+  /// depth counts transactions still queued, it is kept
+  void reset() {
+    this->max_depth = this->depth;
+    this->transactions = 0;
+    this->last_wait_us = 0;
+    this->max_wait_us = 0;
+    this->total_wait_us = 0;
+  }
+};
+
+#ifdef USE_SPI_STATS
+/** Wire usage of one SPI device, all counters only ever grow.
+ *
+ * The counters are atomic, a render task may drive the device while the main loop reads them. Each counter
+ * is consistent on its own, not with the others.
+ */
+struct SPIDeviceStats {
+  std::atomic<uint64_t> bytes_written{0};
+  std::atomic<uint64_t> bytes_read{0};
+  /// enable()/disable() pairs, every transaction on the bus whether queued or not
+  std::atomic<uint32_t> enables{0};
+  /// time enable() waited for another task to give the bus back
+  std::atomic<uint64_t> bus_wait_us{0};
+  /// time between enable() and disable()
+  std::atomic<uint64_t> held_us{0};
+  /// only touched by whoever holds the bus
+  uint32_t enabled_at_us{0};
+
+  void add_written(size_t length) { this->bytes_written.fetch_add(length, std::memory_order_relaxed); }
+  void add_read(size_t length) { this->bytes_read.fetch_add(length, std::memory_order_relaxed); }
+  void reset() {
+    this->bytes_written.store(0, std::memory_order_relaxed);
+    this->bytes_read.store(0, std::memory_order_relaxed);
+    this->enables.store(0, std::memory_order_relaxed);
+    this->bus_wait_us.store(0, std::memory_order_relaxed);
+    this->held_us.store(0, std::memory_order_relaxed);
+  }
+};
+#endif  // USE_SPI_STATS
+
+struct SPITransaction {
+  uint8_t priority;
+  uint32_t sequence;
+  uint32_t queued_us;
+  SPIQueueStats *stats;
+  std::function<void()> run;
+};
+
 class SPIComponent : public Component {
  public:
   void set_clk(GPIOPin *clk) { clk_ = clk; }
   void set_miso(GPIOPin *miso) { miso_ = miso; }
   void set_mosi(GPIOPin *mosi) { mosi_ = mosi; }
+  void set_transaction_queue(bool transaction_queue) { transaction_queue_ = transaction_queue; }
 
   void setup() override;
 
@@ -85,6 +170,18 @@ class SPIComponent : public Component {
       return this->hw_spi_->transfer(0x00);
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      return this->dma_transfer_byte_(0x00);
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_) {
+      uint8_t data;
+      this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, true, false>(nullptr, &data, 1);
+      return data;
+    }
+#endif  // USE_SPI_FAST_GPIO
     return this->transfer_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, true, false>(0x00);
   }
 
@@ -96,6 +193,19 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      memset(data, 0, length);
+      this->dma_transfer_(data, length);
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_) {
+      this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, true, false>(nullptr, data, length);
+      return;
+    }
+#endif  // USE_SPI_FAST_GPIO
     for (size_t i = 0; i < length; i++) {
       data[i] = this->read_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>();
     }
@@ -109,6 +219,18 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      this->dma_write_(&data, 1, false);
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_) {
+      this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, false, true>(&data, nullptr, 1);
+      return;
+    }
+#endif  // USE_SPI_FAST_GPIO
     this->transfer_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, false, true>(data);
   }
 
@@ -120,6 +242,19 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      this->dma_write_(reinterpret_cast<const uint8_t *>(&data), 2, BIT_ORDER == BIT_ORDER_MSB_FIRST);
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_) {
+      uint8_t bytes[2] = {uint8_t(data >> 8), uint8_t(data)};
+      this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, false, true>(bytes, nullptr, 2);
+      return;
+    }
+#endif  // USE_SPI_FAST_GPIO
 
     this->write_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data >> 8);
     this->write_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data);
@@ -133,6 +268,16 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      uint8_t bytes[4] = {uint8_t(data >> 24), uint8_t(data >> 16), uint8_t(data >> 8), uint8_t(data)};
+      if (BIT_ORDER == BIT_ORDER_LSB_FIRST) {
+        std::reverse(bytes, bytes + 4);
+      }
+      this->dma_write_(bytes, 4, false);
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
 
     this->write_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data >> 24);
     this->write_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data >> 16);
@@ -150,6 +295,29 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      this->dma_write_(reinterpret_cast<const uint8_t *>(data), length * 2, BIT_ORDER == BIT_ORDER_MSB_FIRST);
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_) {
+      // split into bytes in small chunks so the bit loop runs over a whole chunk at once
+      uint8_t bytes[64];
+      while (length > 0) {
+        size_t count = std::min<size_t>(length, sizeof(bytes) / 2);
+        for (size_t i = 0; i < count; i++) {
+          bytes[i * 2] = data[i] >> 8;
+          bytes[i * 2 + 1] = data[i];
+        }
+        this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, false, true>(bytes, nullptr, count * 2);
+        data += count;
+        length -= count;
+      }
+      return;
+    }
+#endif  // USE_SPI_FAST_GPIO
     for (size_t i = 0; i < length; i++) {
       this->write_byte16<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data[i]);
     }
@@ -164,6 +332,18 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      this->dma_write_(data, length, false);
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_) {
+      this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, false, true>(data, nullptr, length);
+      return;
+    }
+#endif  // USE_SPI_FAST_GPIO
     for (size_t i = 0; i < length; i++) {
       this->write_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data[i]);
     }
@@ -172,6 +352,17 @@ class SPIComponent : public Component {
   template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE>
   uint8_t transfer_byte(uint8_t data) {
     if (this->miso_ != nullptr) {
+#ifdef USE_SPI_DMA_BACKEND
+      if (this->dma_device_ != nullptr) {
+        return this->dma_transfer_byte_(data);
+      }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+      if (this->fast_gpio_) {
+        this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, true, true>(&data, &data, 1);
+        return data;
+      }
+#endif  // USE_SPI_FAST_GPIO
 #ifdef USE_SPI_ARDUINO_BACKEND
       if (this->hw_spi_ != nullptr) {
         return this->hw_spi_->transfer(data);
@@ -198,6 +389,22 @@ class SPIComponent : public Component {
       return;
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr) {
+      if (this->miso_ != nullptr) {
+        this->dma_transfer_(data, length);
+      } else {
+        this->dma_write_(data, length, false);
+      }
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+#ifdef USE_SPI_FAST_GPIO
+    if (this->fast_gpio_ && this->miso_ != nullptr) {
+      this->transfer_fast_<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, true, true>(data, data, length);
+      return;
+    }
+#endif  // USE_SPI_FAST_GPIO
 
     if (this->miso_ != nullptr) {
       for (size_t i = 0; i < length; i++) {
@@ -208,8 +415,44 @@ class SPIComponent : public Component {
     }
   }
 
+  /** Write a buffer in the background, callback runs once it is on the wire.
+   *
+   * The bus stays taken until the callback ran, so it is the place to end the transaction. It runs from loop()
+   * for writes of the main loop, and from the next access of the same task or wait_async_write() in any case.
+   * data must stay valid until then. Without the DMA backend, or for buffers DMA can't read, the write is
+   * synchronous and the callback runs right away.
+   */
+  template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE>
+  void write_array_async(const uint8_t *data, size_t length, std::function<void()> &&callback) {
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_write_async_(data, length, callback)) {
+      return;
+    }
+#endif  // USE_SPI_DMA_BACKEND
+    this->write_array<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data, length);
+    if (callback) {
+      callback();
+    }
+  }
+  /// Block until an asynchronous write is on the wire and its callback ran
+  void wait_async_write();
+
   template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, uint32_t DATA_RATE>
   void enable(GPIOPin *cs) {
+    this->enable<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(cs, DATA_RATE);
+  }
+
+  /** Take the bus with a data rate chosen at runtime
+   *
+   * The bus stays with the calling task until disable(), devices driven from other tasks wait here.
+   */
+  template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE>
+  void enable(GPIOPin *cs, uint32_t data_rate) {
+#ifdef USE_ESP32
+    if (this->bus_lock_ != nullptr) {
+      xSemaphoreTakeRecursive(this->bus_lock_, portMAX_DELAY);
+    }
+#endif  // USE_ESP32
 #ifdef USE_SPI_ARDUINO_BACKEND
     if (this->hw_spi_ != nullptr) {
       uint8_t data_mode = SPI_MODE0;
@@ -220,13 +463,24 @@ class SPIComponent : public Component {
       } else if (CLOCK_POLARITY && CLOCK_PHASE) {
         data_mode = SPI_MODE3;
       }
-      SPISettings settings(DATA_RATE, BIT_ORDER, data_mode);
+      SPISettings settings(data_rate, BIT_ORDER, data_mode);
       this->hw_spi_->beginTransaction(settings);
     } else {
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+    if (this->dma_device_ != nullptr || this->dma_buffers_[0] != nullptr) {
+      // an asynchronous write of this task ends its transaction first
+      this->dma_wait_();
+      this->dma_configure_(uint8_t(CLOCK_POLARITY) << 1 | uint8_t(CLOCK_PHASE), data_rate,
+                           BIT_ORDER == BIT_ORDER_LSB_FIRST);
+    } else {
+#endif  // USE_SPI_DMA_BACKEND
       this->clk_->digital_write(CLOCK_POLARITY);
       uint32_t cpu_freq_hz = arch_get_cpu_freq_hz();
-      this->wait_cycle_ = uint32_t(cpu_freq_hz) / DATA_RATE / 2ULL;
+      this->wait_cycle_ = uint32_t(cpu_freq_hz) / data_rate / 2ULL;
+#ifdef USE_SPI_DMA_BACKEND
+    }
+#endif  // USE_SPI_DMA_BACKEND
 #ifdef USE_SPI_ARDUINO_BACKEND
     }
 #endif  // USE_SPI_ARDUINO_BACKEND
@@ -239,6 +493,20 @@ class SPIComponent : public Component {
 
   void disable();
 
+  /** Run a transaction on the bus.
+   *
+   * Without a transaction queue the transaction runs right away. With one it is queued and run from loop(),
+   * highest priority first and in submission order within a priority, so a long upload split into several
+   * transactions lets short ones from other devices in between. A transaction takes the bus itself with
+   * enable()/disable() and must not keep it across calls.
+   */
+  void submit(uint8_t priority, SPIQueueStats *stats, std::function<void()> &&transaction);
+  bool is_queue_empty() const { return this->queue_.empty(); }
+  /// Run every queued transaction now, for callers that have to block until their work is on the wire
+  void flush_queue();
+
+  void loop() override;
+
   float get_setup_priority() const override;
 
  protected:
@@ -247,13 +515,59 @@ class SPIComponent : public Component {
   template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, bool READ, bool WRITE>
   uint8_t transfer_(uint8_t data);
 
+#ifdef USE_SPI_FAST_GPIO
+  /// Bit-bang length bytes through the GPIO registers, write_data and read_data may be the same buffer.
+  template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, bool READ, bool WRITE>
+  void transfer_fast_(const uint8_t *write_data, uint8_t *read_data, size_t length);
+
+  bool fast_gpio_{false};
+  FastGPIO fast_clk_;
+  FastGPIO fast_miso_;
+  FastGPIO fast_mosi_;
+#endif  // USE_SPI_FAST_GPIO
+
   GPIOPin *clk_;
   GPIOPin *miso_{nullptr};
   GPIOPin *mosi_{nullptr};
   GPIOPin *active_cs_{nullptr};
+#ifdef USE_ESP32
+  // held from enable() to disable(), so a task can't cut into a transaction of the main loop or the other way round
+  SemaphoreHandle_t bus_lock_{nullptr};
+#endif  // USE_ESP32
+  bool transaction_queue_{false};
+  std::vector<SPITransaction> queue_;
+  uint32_t queue_sequence_{0};
+  HighFrequencyLoopRequester high_freq_;
 #ifdef USE_SPI_ARDUINO_BACKEND
   SPIClass *hw_spi_{nullptr};
 #endif  // USE_SPI_ARDUINO_BACKEND
+#ifdef USE_SPI_DMA_BACKEND
+  bool dma_loop_();
+  bool dma_write_async_(const uint8_t *data, size_t length, std::function<void()> &callback);
+  void dma_refill_();
+  void dma_configure_(uint8_t mode, uint32_t clock, bool lsb_first);
+  uint8_t dma_transfer_byte_(uint8_t data);
+  void dma_transfer_(uint8_t *data, size_t length);
+  void dma_write_(const uint8_t *data, size_t length, bool swap16);
+  void dma_queue_(uint8_t slot, const uint8_t *data, size_t length);
+  void dma_collect_(bool block);
+  void dma_wait_();
+
+  spi_device_handle_t dma_device_{nullptr};
+  // bounce buffers, the frame buffers usually live in PSRAM which DMA can't read
+  uint8_t *dma_buffers_[2]{nullptr, nullptr};
+  spi_transaction_t dma_transactions_[2];
+  uint8_t dma_next_slot_{0};
+  uint8_t dma_in_flight_{0};
+  uint8_t dma_mode_{0xFF};
+  uint32_t dma_clock_{0};
+  bool dma_lsb_first_{false};
+  // asynchronous write state, only touched by the task holding the bus
+  bool async_active_{false};
+  const uint8_t *async_data_{nullptr};
+  size_t async_remaining_{0};
+  std::function<void()> async_callback_;
+#endif  // USE_SPI_DMA_BACKEND
   uint32_t wait_cycle_;
 };
 
@@ -273,13 +587,58 @@ class SPIDevice {
     }
   }
 
-  void enable() { this->parent_->template enable<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE, DATA_RATE>(this->cs_); }
+  void enable() {
+#ifdef USE_SPI_STATS
+    uint32_t start = micros();
+#endif  // USE_SPI_STATS
+    this->parent_->template enable<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(this->cs_, this->get_data_rate());
+#ifdef USE_SPI_STATS
+    this->stats_.enables.fetch_add(1, std::memory_order_relaxed);
+    this->stats_.enabled_at_us = micros();
+    this->stats_.bus_wait_us.fetch_add(this->stats_.enabled_at_us - start, std::memory_order_relaxed);
+#endif  // USE_SPI_STATS
+  }
+
+  void disable() {
+    this->parent_->disable();
+#ifdef USE_SPI_STATS
+    this->stats_.held_us.fetch_add(micros() - this->stats_.enabled_at_us, std::memory_order_relaxed);
+#endif  // USE_SPI_STATS
+  }
+
+  void set_spi_priority(uint8_t priority) { spi_priority_ = priority; }
+
+  /// Override the DATA_RATE template parameter at runtime, 0 goes back to the template parameter.
+  void set_data_rate(uint32_t data_rate) { data_rate_ = data_rate; }
+  uint32_t get_data_rate() const { return this->data_rate_ != 0 ? this->data_rate_ : uint32_t(DATA_RATE); }
 
-  void disable() { this->parent_->disable(); }
+  /// Run a transaction on the bus at this device's priority, see SPIComponent::submit()
+  void submit(std::function<void()> &&transaction) {
+    this->parent_->submit(this->spi_priority_, &this->queue_stats_, std::move(transaction));
+  }
+  void flush_transactions() { this->parent_->flush_queue(); }
+
+  const SPIQueueStats *get_queue_stats() const { return &this->queue_stats_; }
+#ifdef USE_SPI_STATS
+  const SPIDeviceStats *get_spi_stats() const { return &this->stats_; }
+  /// Only from the main loop, the queue counters are not atomic
+  void reset_spi_stats() {
+    this->stats_.reset();
+    this->queue_stats_.reset();
+  }
+#endif  // USE_SPI_STATS
 
-  uint8_t read_byte() { return this->parent_->template read_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(); }
+  uint8_t read_byte() {
+#ifdef USE_SPI_STATS
+    this->stats_.add_read(1);
+#endif  // USE_SPI_STATS
+    return this->parent_->template read_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>();
+  }
 
   void read_array(uint8_t *data, size_t length) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_read(length);
+#endif  // USE_SPI_STATS
     return this->parent_->template read_array<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data, length);
   }
 
@@ -290,34 +649,67 @@ class SPIDevice {
   }
 
   void write_byte(uint8_t data) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(1);
+#endif  // USE_SPI_STATS
     return this->parent_->template write_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data);
   }
 
   void write_byte16(uint16_t data) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(2);
+#endif  // USE_SPI_STATS
     return this->parent_->template write_byte16<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data);
   }
 
   void write_byte32(uint32_t data) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(4);
+#endif  // USE_SPI_STATS
     return this->parent_->template write_byte32<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data);
   }
 
   void write_array16(const uint16_t *data, size_t length) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(length * 2);
+#endif  // USE_SPI_STATS
     this->parent_->template write_array16<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data, length);
   }
 
   void write_array(const uint8_t *data, size_t length) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(length);
+#endif  // USE_SPI_STATS
     this->parent_->template write_array<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data, length);
   }
 
+  /// See SPIComponent::write_array_async(), the callback usually ends with disable()
+  void write_array_async(const uint8_t *data, size_t length, std::function<void()> &&callback) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(length);
+#endif  // USE_SPI_STATS
+    this->parent_->template write_array_async<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data, length,
+                                                                                     std::move(callback));
+  }
+  void wait_async_write() { this->parent_->wait_async_write(); }
+
   template<size_t N> void write_array(const std::array<uint8_t, N> &data) { this->write_array(data.data(), N); }
 
   void write_array(const std::vector<uint8_t> &data) { this->write_array(data.data(), data.size()); }
 
   uint8_t transfer_byte(uint8_t data) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(1);
+    this->stats_.add_read(1);
+#endif  // USE_SPI_STATS
     return this->parent_->template transfer_byte<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data);
   }
 
   void transfer_array(uint8_t *data, size_t length) {
+#ifdef USE_SPI_STATS
+    this->stats_.add_written(length);
+    this->stats_.add_read(length);
+#endif  // USE_SPI_STATS
     this->parent_->template transfer_array<BIT_ORDER, CLOCK_POLARITY, CLOCK_PHASE>(data, length);
   }
 
@@ -326,6 +718,12 @@ class SPIDevice {
  protected:
   SPIComponent *parent_{nullptr};
   GPIOPin *cs_{nullptr};
+  uint8_t spi_priority_{0};
+  uint32_t data_rate_{0};
+  SPIQueueStats queue_stats_;
+#ifdef USE_SPI_STATS
+  SPIDeviceStats stats_;
+#endif  // USE_SPI_STATS
 };
 
 }  // namespace spi
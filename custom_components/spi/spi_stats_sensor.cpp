@@ -0,0 +1,82 @@
+#include "spi_stats_sensor.h"
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#ifdef USE_SPI_STATS
+
+namespace esphome {
+namespace spi {
+
+static const char *const TAG = "spi.stats";
+
+/// Growth of a counter since the last update, reset_spi_stats() starts it over from zero
+template<typename T> static T since_last(T value, T last) { return value >= last ? value - last : value; }
+
+void SPIStatsSensor::update() {
+  uint32_t now = micros();
+  // the device may be driven from another task, every counter is read once
+  uint64_t held_us = this->stats_->held_us.load(std::memory_order_relaxed);
+  uint32_t enables = this->stats_->enables.load(std::memory_order_relaxed);
+  uint64_t bus_wait_us = this->stats_->bus_wait_us.load(std::memory_order_relaxed);
+
+  if (this->bytes_written_sensor_ != nullptr)
+    this->bytes_written_sensor_->publish_state(this->stats_->bytes_written.load(std::memory_order_relaxed));
+  if (this->bytes_read_sensor_ != nullptr)
+    this->bytes_read_sensor_->publish_state(this->stats_->bytes_read.load(std::memory_order_relaxed));
+  if (this->queued_transactions_sensor_ != nullptr)
+    this->queued_transactions_sensor_->publish_state(this->queue_stats_->transactions);
+  if (this->enables_sensor_ != nullptr)
+    this->enables_sensor_->publish_state(enables);
+  if (this->bus_time_sensor_ != nullptr)
+    this->bus_time_sensor_->publish_state(held_us / 1000.0f);
+
+  // share of the last interval the device held the bus
+  if (this->bus_utilization_sensor_ != nullptr && this->last_update_us_ != 0) {
+    uint32_t interval = now - this->last_update_us_;
+    float held = since_last(held_us, this->last_held_us_);
+    this->bus_utilization_sensor_->publish_state(interval > 0 ? held * 100.0f / interval : 0.0f);
+  }
+
+  if (this->queue_depth_sensor_ != nullptr)
+    this->queue_depth_sensor_->publish_state(this->queue_stats_->max_depth);
+
+  // average queue wait of the transactions submitted since the last update, direct ones never queue
+  if (this->queue_wait_sensor_ != nullptr) {
+    uint32_t transactions = since_last(this->queue_stats_->transactions, this->last_transactions_);
+    uint64_t wait = since_last(this->queue_stats_->total_wait_us, this->last_total_wait_us_);
+    this->queue_wait_sensor_->publish_state(transactions > 0 ? wait / 1000.0f / transactions : 0.0f);
+  }
+
+  // average wait for the bus lock of every transaction since the last update, queued or not
+  if (this->bus_wait_sensor_ != nullptr) {
+    uint32_t transactions = since_last(enables, this->last_enables_);
+    uint64_t wait = since_last(bus_wait_us, this->last_bus_wait_us_);
+    this->bus_wait_sensor_->publish_state(transactions > 0 ? wait / 1000.0f / transactions : 0.0f);
+  }
+
+  this->last_update_us_ = now;
+  this->last_held_us_ = held_us;
+  this->last_transactions_ = this->queue_stats_->transactions;
+  this->last_total_wait_us_ = this->queue_stats_->total_wait_us;
+  this->last_enables_ = enables;
+  this->last_bus_wait_us_ = bus_wait_us;
+}
+
+void SPIStatsSensor::dump_config() {
+  ESP_LOGCONFIG(TAG, "SPI Device Stats:");
+  LOG_UPDATE_INTERVAL(this);
+  LOG_SENSOR("  ", "Bytes Written", this->bytes_written_sensor_);
+  LOG_SENSOR("  ", "Bytes Read", this->bytes_read_sensor_);
+  LOG_SENSOR("  ", "Queued Transactions", this->queued_transactions_sensor_);
+  LOG_SENSOR("  ", "Enables", this->enables_sensor_);
+  LOG_SENSOR("  ", "Bus Time", this->bus_time_sensor_);
+  LOG_SENSOR("  ", "Bus Utilization", this->bus_utilization_sensor_);
+  LOG_SENSOR("  ", "Queue Depth", this->queue_depth_sensor_);
+  LOG_SENSOR("  ", "Queue Wait", this->queue_wait_sensor_);
+  LOG_SENSOR("  ", "Bus Wait", this->bus_wait_sensor_);
+}
+
+}  // namespace spi
+}  // namespace esphome
+
+#endif  // USE_SPI_STATS
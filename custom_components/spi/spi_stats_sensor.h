@@ -0,0 +1,59 @@
+#pragma once
+
+#include "esphome/core/component.h"
+#include "esphome/core/defines.h"
+#include "esphome/components/sensor/sensor.h"
+#include "spi.h"
+
+#ifdef USE_SPI_STATS
+
+namespace esphome {
+namespace spi {
+
+/// Publishes the wire usage counters of one SPI device.
+class SPIStatsSensor : public PollingComponent {
+ public:
+  void set_stats(const SPIDeviceStats *stats) { stats_ = stats; }
+  void set_queue_stats(const SPIQueueStats *queue_stats) { queue_stats_ = queue_stats; }
+
+  void set_bytes_written_sensor(sensor::Sensor *sensor) { bytes_written_sensor_ = sensor; }
+  void set_bytes_read_sensor(sensor::Sensor *sensor) { bytes_read_sensor_ = sensor; }
+  void set_queued_transactions_sensor(sensor::Sensor *sensor) { queued_transactions_sensor_ = sensor; }
+  void set_enables_sensor(sensor::Sensor *sensor) { enables_sensor_ = sensor; }
+  void set_bus_time_sensor(sensor::Sensor *sensor) { bus_time_sensor_ = sensor; }
+  void set_bus_utilization_sensor(sensor::Sensor *sensor) { bus_utilization_sensor_ = sensor; }
+  void set_queue_depth_sensor(sensor::Sensor *sensor) { queue_depth_sensor_ = sensor; }
+  void set_queue_wait_sensor(sensor::Sensor *sensor) { queue_wait_sensor_ = sensor; }
+  void set_bus_wait_sensor(sensor::Sensor *sensor) { bus_wait_sensor_ = sensor; }
+
+  void update() override;
+  void dump_config() override;
+  float get_setup_priority() const override { return setup_priority::DATA; }
+
+ protected:
+  const SPIDeviceStats *stats_{nullptr};
+  const SPIQueueStats *queue_stats_{nullptr};
+
+  sensor::Sensor *bytes_written_sensor_{nullptr};
+  sensor::Sensor *bytes_read_sensor_{nullptr};
+  sensor::Sensor *queued_transactions_sensor_{nullptr};
+  sensor::Sensor *enables_sensor_{nullptr};
+  sensor::Sensor *bus_time_sensor_{nullptr};
+  sensor::Sensor *bus_utilization_sensor_{nullptr};
+  sensor::Sensor *queue_depth_sensor_{nullptr};
+  sensor::Sensor *queue_wait_sensor_{nullptr};
+  sensor::Sensor *bus_wait_sensor_{nullptr};
+
+  // state at the previous update, for the per interval values
+  uint64_t last_held_us_{0};
+  uint32_t last_update_us_{0};
+  uint32_t last_transactions_{0};
+  uint64_t last_total_wait_us_{0};
+  uint32_t last_enables_{0};
+  uint64_t last_bus_wait_us_{0};
+};
+
+}  // namespace spi
+}  // namespace esphome
+
+#endif  // USE_SPI_STATS